@@ -0,0 +1,43 @@
+/**
+ * @file AllocCounter.h
+ * @brief Debug count of heap allocations, used to check that steady-state rounds allocate nothing
+ *
+ * Built with KCORE_ALLOC_CHECK (cmake -DKCORE_ALLOC_CHECK=ON) this header
+ * replaces the global operator new/delete with counting versions, so it may
+ * only be included by one translation unit per binary (every binary of this
+ * repository is a single one). Otherwise heapAllocations() stays at zero.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace distributed_kcore {
+
+inline std::atomic<unsigned long long>& heapAllocations() {
+    static std::atomic<unsigned long long> count{0};
+    return count;
+}
+
+} // end of namespace distributed_kcore
+
+#ifdef KCORE_ALLOC_CHECK
+// kept out of line so the compiler does not pair the inlined malloc/free with new/delete expressions
+__attribute__((noinline)) void* operator new(std::size_t size) {
+    distributed_kcore::heapAllocations().fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size > 0 ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+#endif
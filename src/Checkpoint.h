@@ -0,0 +1,371 @@
+/**
+ * @file Checkpoint.h
+ * @brief Periodic checkpoint/restart of the KCore round state
+ *
+ * Every rank writes its own file into the checkpoint directory, alternating
+ * between two slots so that a crash in the middle of a write always leaves the
+ * previous generation intact. The coordinator stores the LDS levels,
+ * permanentZeros and roundThresholds; workers keep no state across rounds, so
+ * their files only carry the header and mark the round as reached on that rank.
+ *
+ * The header also records the run settings and a fingerprint of the graph
+ * (CheckpointSettings); --resume refuses a checkpoint written with different
+ * ones. Without --checkpoint-every the interval adapts after every write so
+ * that writing stays near kCheckpointTargetOverhead of the round time.
+*/
+
+#pragma once
+
+#include <mpi.h>
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "CounterRng.h"
+#include "LDS.h"
+
+namespace distributed_kcore {
+
+// Share of the round time that the adaptive checkpoint interval aims to spend on writes.
+static constexpr double kCheckpointTargetOverhead = 0.02;
+
+// What a checkpoint was computed with; a resume must match all of it.
+struct CheckpointSettings {
+    double epsilon = 0.0;
+    double phi = 0.0;
+    double factor = 0.0;
+    int32_t bias = 0;
+    int32_t biasFactor = 0;
+    int32_t levelsPerGroup = 0;
+    // RngBackend; with philox the seed is the whole noise state, so it must match too
+    uint32_t rngBackend = 0;
+    uint64_t rngSeed = 0;
+    // adjacency entries summed over the workers
+    uint64_t graphEntries = 0;
+};
+
+struct CheckpointHeader {
+    uint32_t magic;
+    uint32_t version;
+    int32_t rank;
+    int32_t nprocs;
+    int64_t n;
+    int32_t round;
+    uint32_t hasState;
+    uint64_t checksum; // FNV-1a over the payload
+    CheckpointSettings settings;
+};
+
+// Names the first setting that differs between a checkpoint and this run, or returns "".
+inline std::string settingsMismatch(const CheckpointSettings& saved, const CheckpointSettings& now) {
+    auto describe = [](const char* name, auto a, auto b) {
+        return std::string(name) + " " + std::to_string(a) + " (this run: " + std::to_string(b) + ")";
+    };
+    if (saved.epsilon != now.epsilon) {
+        return describe("epsilon", saved.epsilon, now.epsilon);
+    }
+    if (saved.phi != now.phi) {
+        return describe("phi", saved.phi, now.phi);
+    }
+    if (saved.factor != now.factor) {
+        return describe("threshold factor", saved.factor, now.factor);
+    }
+    if (saved.bias != now.bias || saved.biasFactor != now.biasFactor) {
+        return describe("bias", saved.bias, now.bias) + ", " + describe("bias factor", saved.biasFactor, now.biasFactor);
+    }
+    if (saved.levelsPerGroup != now.levelsPerGroup) {
+        return describe("levels per group", saved.levelsPerGroup, now.levelsPerGroup);
+    }
+    if (saved.rngBackend != now.rngBackend) {
+        return std::string("--rng=") + (saved.rngBackend == RNG_PHILOX ? "philox" : "secure") + " (this run: --rng="
+               + (now.rngBackend == RNG_PHILOX ? "philox" : "secure") + ")";
+    }
+    if (now.rngBackend == RNG_PHILOX && saved.rngSeed != now.rngSeed) {
+        return "--seed=" + std::to_string(saved.rngSeed) + " (this run: --seed=" + std::to_string(now.rngSeed) + ")";
+    }
+    if (saved.graphEntries != now.graphEntries) {
+        return describe("graph adjacency entries", saved.graphEntries, now.graphEntries);
+    }
+    return "";
+}
+
+class Checkpointer {
+    private:
+        static constexpr uint32_t kMagic = 0x4b43434b; // "KCCK"
+        static constexpr uint32_t kVersion = 3;
+
+        std::string dir;
+        // 0: adaptive, see reschedule()
+        int every;
+        int rank;
+        int nprocs;
+        int64_t n;
+        CheckpointSettings settings;
+        int written = 0;
+        int nextSlot = 0;
+        double writeTime = 0.0;
+        // adaptive interval in rounds (the first write is priced as if it cost one round) and the round time since the last write
+        int interval = static_cast<int>(1.0 / kCheckpointTargetOverhead);
+        double roundTimeSinceWrite = 0.0;
+        int roundsSinceWrite = 0;
+        // set by readSlot() when a slot of this rank was written with other settings
+        std::string mismatch;
+
+        static uint64_t fnv1a(const std::vector<char>& bytes) {
+            uint64_t hash = 1469598103934665603ULL;
+            for (char c : bytes) {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        template <class T>
+        static void append(std::vector<char>& bytes, const T* data, size_t count) {
+            const char* p = reinterpret_cast<const char*>(data);
+            bytes.insert(bytes.end(), p, p + count * sizeof(T));
+        }
+
+        // Writes all of buf to path and fsyncs it before closing.
+        static bool writeDurably(const std::string& path, const char* buf, size_t len) {
+            int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0) {
+                return false;
+            }
+            size_t done = 0;
+            while (done < len) {
+                ssize_t written = ::write(fd, buf + done, len - done);
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    ::close(fd);
+                    return false;
+                }
+                done += static_cast<size_t>(written);
+            }
+            bool ok = ::fsync(fd) == 0;
+            return ::close(fd) == 0 && ok;
+        }
+
+        // fsyncs the checkpoint directory so a rename in it is durable.
+        bool syncDir() const {
+            int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+            if (fd < 0) {
+                return false;
+            }
+            bool ok = ::fsync(fd) == 0;
+            ::close(fd);
+            return ok;
+        }
+
+        std::string slotPath(int slot) const {
+            return dir + "/kcore_rank" + std::to_string(rank) + "_slot" + std::to_string(slot) + ".ckpt";
+        }
+
+        // Reads and validates one slot; returns the stored round or -1.
+        int readSlot(int slot, CheckpointHeader& header, std::vector<char>& payload) {
+            std::ifstream in(slotPath(slot), std::ios::binary);
+            if (!in.is_open()) {
+                return -1;
+            }
+            if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+                return -1;
+            }
+            if (header.magic != kMagic || header.version != kVersion || header.rank != rank
+                    || header.nprocs != nprocs || header.n != n) {
+                return -1;
+            }
+            std::string differs = settingsMismatch(header.settings, settings);
+            if (!differs.empty()) {
+                mismatch = differs;
+                return -1;
+            }
+            payload.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            if (fnv1a(payload) != header.checksum) {
+                return -1;
+            }
+            return header.round;
+        }
+
+    public:
+        // Collective (adaptive interval only). Spaces the next write so it costs about kCheckpointTargetOverhead of the rounds before it.
+        void reschedule(double seconds) {
+            double local[2] = {seconds, roundTimeSinceWrite / std::max(roundsSinceWrite, 1)}, slowest[2];
+            MPI_Allreduce(local, slowest, 2, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+            interval = 1;
+            if (slowest[1] > 0.0) {
+                interval = std::max(static_cast<int>(std::min(std::ceil(slowest[0] / (kCheckpointTargetOverhead * slowest[1])), 1e6)), 1);
+            }
+            roundTimeSinceWrite = 0.0;
+            roundsSinceWrite = 0;
+        }
+
+    public:
+        // every == 0 picks the interval adaptively.
+        Checkpointer(const std::string& _dir, int _every, int _rank, int _nprocs, int64_t _n, const CheckpointSettings& _settings) : dir(_dir),
+            every(_every), rank(_rank), nprocs(_nprocs), n(_n), settings(_settings) {
+                std::filesystem::create_directories(dir);
+        }
+
+        // Called by every rank after each round, before due().
+        void addRoundTime(double seconds) {
+            roundTimeSinceWrite += seconds;
+            roundsSinceWrite++;
+        }
+
+        bool due(int round) const {
+            if (every == 0) {
+                return roundsSinceWrite >= interval;
+            }
+            return (round + 1) % every == 0;
+        }
+
+        /**
+         * Writes the state after `round` has completed. Workers pass lds == nullptr.
+         * The file is written and fsynced under a temporary name, renamed, and
+         * the directory fsynced, so after a crash or power loss a slot is
+         * either the complete old generation or the complete new one. A
+         * failed write leaves nextSlot where it was. Collective when the
+         * interval is adaptive.
+        */
+        template <class L>
+        void write(int round, L* lds, const std::vector<int>& permanentZeros, const std::vector<int>& roundThresholds) {
+            auto start = std::chrono::high_resolution_clock::now();
+            if (writeSlot(round, lds, permanentZeros, roundThresholds)) {
+                nextSlot = 1 - nextSlot;
+                written++;
+            }
+            std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+            writeTime += elapsed.count();
+            if (every == 0) {
+                reschedule(elapsed.count());
+            }
+        }
+
+        template <class L>
+        bool writeSlot(int round, L* lds, const std::vector<int>& permanentZeros, const std::vector<int>& roundThresholds) {
+            std::vector<char> payload;
+            if (lds != nullptr) {
+                payload.reserve(static_cast<size_t>(n) * 2 * sizeof(uint32_t) + n / 8 + 1);
+                std::vector<uint32_t> levels(n);
+                for (int64_t i = 0; i < n; i++) {
+                    levels[i] = lds->get_level(i);
+                }
+                append(payload, levels.data(), levels.size());
+                // permanentZeros only holds 0/1, pack it into a bitmap
+                std::vector<uint8_t> bits((n + 7) / 8, 0);
+                for (int64_t i = 0; i < n; i++) {
+                    if (permanentZeros[i] != 0) {
+                        bits[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+                    }
+                }
+                append(payload, bits.data(), bits.size());
+                append(payload, roundThresholds.data(), roundThresholds.size());
+            }
+
+            CheckpointHeader header{kMagic, kVersion, rank, nprocs, n, round, lds != nullptr ? 1u : 0u, fnv1a(payload), settings};
+            std::string path = slotPath(nextSlot);
+            std::string tmp = path + ".tmp";
+            payload.insert(payload.begin(), reinterpret_cast<const char*>(&header), reinterpret_cast<const char*>(&header) + sizeof(header));
+            if (!writeDurably(tmp, payload.data(), payload.size())) {
+                std::cerr << "Failed to write checkpoint: " << tmp << " (" << std::strerror(errno) << ")" << std::endl;
+                std::remove(tmp.c_str());
+                return false;
+            }
+            if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+                std::cerr << "Failed to rename checkpoint: " << tmp << " (" << std::strerror(errno) << ")" << std::endl;
+                std::remove(tmp.c_str());
+                return false;
+            }
+            if (!syncDir()) {
+                std::cerr << "Failed to sync checkpoint directory: " << dir << " (" << std::strerror(errno) << ")" << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * Collective. Returns the newest round for which every rank holds a valid
+         * checkpoint, or -1 if there is none or one was written with other
+         * settings (reported on stderr).
+        */
+        int latestConsistentRound() {
+            CheckpointHeader header;
+            std::vector<char> payload;
+            mismatch.clear();
+            int rounds[2] = {readSlot(0, header, payload), readSlot(1, header, payload)};
+            int conflicting = mismatch.empty() ? 0 : 1, anyConflicting;
+            MPI_Allreduce(&conflicting, &anyConflicting, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+            if (anyConflicting) {
+                // the lowest rank that saw a mismatch reports it
+                int reporter = conflicting ? rank : nprocs, first;
+                MPI_Allreduce(&reporter, &first, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+                if (rank == first) {
+                    std::cerr << "Not resuming: the checkpoint in " << dir << " was written with " << mismatch << std::endl;
+                }
+                return -1;
+            }
+            int newest = std::max(rounds[0], rounds[1]);
+            int candidate;
+            MPI_Allreduce(&newest, &candidate, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+            int haveIt = (candidate >= 0 && (rounds[0] == candidate || rounds[1] == candidate)) ? 1 : 0;
+            int everyone;
+            MPI_Allreduce(&haveIt, &everyone, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+            if (!everyone) {
+                return -1;
+            }
+            // continue writing into the slot that does not hold the restored round
+            nextSlot = (rounds[0] == candidate) ? 1 : 0;
+            return candidate;
+        }
+
+        // Restores the coordinator state saved for `round`.
+        template <class L>
+        bool load(int round, L* lds, std::vector<int>& permanentZeros, std::vector<int>& roundThresholds) {
+            CheckpointHeader header;
+            std::vector<char> payload;
+            int slot = (readSlot(0, header, payload) == round) ? 0 : 1;
+            if (readSlot(slot, header, payload) != round || header.hasState != 1) {
+                return false;
+            }
+            size_t bitBytes = (n + 7) / 8;
+            if (payload.size() != static_cast<size_t>(n) * 2 * sizeof(uint32_t) + bitBytes) {
+                return false;
+            }
+            const char* p = payload.data();
+            for (int64_t i = 0; i < n; i++) {
+                uint32_t level;
+                std::memcpy(&level, p + i * sizeof(uint32_t), sizeof(uint32_t));
+                lds->L[i].level = level;
+            }
+            p += static_cast<size_t>(n) * sizeof(uint32_t);
+            for (int64_t i = 0; i < n; i++) {
+                permanentZeros[i] = (static_cast<uint8_t>(p[i / 8]) >> (i % 8)) & 1;
+            }
+            p += bitBytes;
+            std::memcpy(roundThresholds.data(), p, static_cast<size_t>(n) * sizeof(int32_t));
+            return true;
+        }
+
+        int checkpointsWritten() const {
+            return written;
+        }
+
+        double getWriteTime() const {
+            return writeTime;
+        }
+};
+
+} // end of namespace distributed_kcore
@@ -0,0 +1,146 @@
+/**
+ * @file CounterRng.h
+ * @brief Choice of the randomness behind the DP noise: OpenSSL (default) or Philox4x32-10
+ *
+ * With --rng=philox every noise sample comes from its own Philox stream
+ * keyed by (seed, purpose) with the counter (draw, round, vertex), so a
+ * sample depends only on what it is for and never on which rank or thread
+ * draws it or in which order: runs with the same --seed give the same core
+ * numbers whatever the number of ranks, --init-threads, --distributed-init
+ * or --rebalance. Philox is not a cryptographic generator, so the noise is
+ * only as private as the seed is secret; it is meant for benchmarking and
+ * bisecting. Builds with KCORE_DETERMINISTIC_RNG (cmake
+ * -DKCORE_DETERMINISTIC_RNG=ON) default to it.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace distributed_kcore {
+
+enum RngBackend {
+    RNG_SECURE,
+    RNG_PHILOX
+};
+
+#ifdef KCORE_DETERMINISTIC_RNG
+static constexpr RngBackend kDefaultRngBackend = RNG_PHILOX;
+#else
+static constexpr RngBackend kDefaultRngBackend = RNG_SECURE;
+#endif
+
+inline bool parseRngBackend(const std::string& name, RngBackend& backend) {
+    if (name == "secure") {
+        backend = RNG_SECURE;
+    } else if (name == "philox") {
+        backend = RNG_PHILOX;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// What a noise sample is for; trial lane t of --trials uses purpose + 2 * t.
+enum NoisePurpose : uint32_t {
+    NOISE_ROUND = 0,
+    NOISE_THRESHOLD = 1
+};
+
+/**
+ * 64-bit URBG over one Philox4x32-10 stream (Salmon et al., "Parallel random
+ * numbers: as easy as 1, 2, 3", SC 2011). The key is the seed mixed with the
+ * purpose, the 128-bit counter is (draw, round, vertex low, vertex high);
+ * each block gives two outputs.
+*/
+class PhiloxURBG {
+    private:
+        uint32_t key[2];
+        uint32_t counter[4];
+        uint32_t block[4];
+        int used = 4;
+
+        static inline uint64_t mix(uint64_t x) {
+            // splitmix64 finaliser
+            x += 0x9E3779B97F4A7C15ull;
+            x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+            x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+            return x ^ (x >> 31);
+        }
+
+        void refill() {
+            uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+            uint32_t k0 = key[0], k1 = key[1];
+            for (int round = 0; round < 10; round++) {
+                uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c0;
+                uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c2;
+                uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+                uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+                c1 = static_cast<uint32_t>(p1);
+                c3 = static_cast<uint32_t>(p0);
+                c0 = n0;
+                c2 = n2;
+                k0 += 0x9E3779B9u;
+                k1 += 0xBB67AE85u;
+            }
+            block[0] = c0;
+            block[1] = c1;
+            block[2] = c2;
+            block[3] = c3;
+            counter[0]++;
+            used = 0;
+        }
+
+    public:
+        using result_type = uint64_t;
+
+        PhiloxURBG(uint64_t seed, uint32_t purpose, uint32_t round, uint64_t vertex) {
+            uint64_t k = mix(seed ^ mix(purpose));
+            key[0] = static_cast<uint32_t>(k);
+            key[1] = static_cast<uint32_t>(k >> 32);
+            counter[0] = 0;
+            counter[1] = round;
+            counter[2] = static_cast<uint32_t>(vertex);
+            counter[3] = static_cast<uint32_t>(vertex >> 32);
+        }
+
+        static constexpr result_type(min)() {
+            return (std::numeric_limits<result_type>::min)();
+        }
+        static constexpr result_type(max)() {
+            return (std::numeric_limits<result_type>::max)();
+        }
+
+        result_type operator()() {
+            if (used == 4) {
+                refill();
+            }
+            uint64_t result = (static_cast<uint64_t>(block[used + 1]) << 32) | block[used];
+            used += 2;
+            return result;
+        }
+};
+
+/**
+ * Where the noise of a run comes from. sample() draws one value from dist
+ * (GeometricDistribution or anything with Sample() and Sample(URBG&)),
+ * from the shared OpenSSL generator or from the Philox stream of
+ * (purpose, round, vertex).
+*/
+struct NoiseSource {
+    RngBackend backend = kDefaultRngBackend;
+    uint64_t seed = 1;
+
+    template <class Distribution, class V>
+    int64_t sample(Distribution& dist, uint32_t purpose, int round, V vertex) const {
+        if (backend == RNG_SECURE) {
+            return dist.Sample();
+        }
+        PhiloxURBG urbg(seed, purpose, static_cast<uint32_t>(round), static_cast<uint64_t>(vertex));
+        return dist.Sample(urbg);
+    }
+};
+
+} // end of namespace distributed_kcore
@@ -0,0 +1,498 @@
+/**
+ * @file DistributedLDS.h
+ * @brief Batch-dynamic level data structure (LDS_approx.h invariants) partitioned over the workers
+ *
+ * Every worker owns the same contiguous vertex slice as in KCore_compute and
+ * keeps, for each owned vertex, its level, its adjacency and the number of
+ * neighbours at or above its level (up) and one level below it (prev). The
+ * levels of remote neighbours are cached and refreshed by the owners, which
+ * announce every level change to the ranks holding a neighbour. As with the
+ * up/down sets of LDS_approx.h, the counts are adjusted as edges and
+ * neighbour levels change; only a vertex that moves rescans its own
+ * neighbours.
+ *
+ * The coordinator reads edge updates and routes each one to the owners of both
+ * endpoints. Invariants are then restored in synchronous fixup rounds: all
+ * vertices violating the upper invariant at the lowest such level move up by
+ * one, or, once there are none, all vertices violating the lower invariant at
+ * the highest such level move down by one. Vertices moving together are at the
+ * same level and move the same way, so none of them changes the others' counts
+ * and the round is equivalent to moving them one after the other as
+ * LDS::fixup() does.
+*/
+
+#pragma once
+
+#include <mpi.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "LDS.h"
+
+namespace distributed_kcore {
+
+// One edge update as sent over MPI: insert is 1 for an insertion and 0 for a deletion.
+struct EdgeUpdate {
+    int u;
+    int v;
+    int insert;
+};
+
+/**
+ * Reads updates from a file ("-" for stdin), one per line: "u v" inserts the
+ * edge and "d u v" deletes it. Blank lines and lines starting with '#' are
+ * skipped; malformed lines are reported and passed on with id -1 so they are
+ * counted as dropped.
+*/
+class UpdateStream {
+    private:
+        std::ifstream file;
+        std::istream* in;
+
+    public:
+        UpdateStream(const std::string& path) : in(&std::cin) {
+            if (path != "-") {
+                file.open(path);
+                if (!file.is_open()) {
+                    std::cerr << "Failed to open file: " << path << std::endl;
+                }
+                in = &file;
+            }
+        }
+
+        // Appends up to maxUpdates updates; returns false once the stream is exhausted.
+        bool next(std::vector<EdgeUpdate>& batch, size_t maxUpdates) {
+            std::string line;
+            while (batch.size() < maxUpdates && std::getline(*in, line)) {
+                if (line.empty() || line[0] == '#') {
+                    continue;
+                }
+                std::stringstream ss(line);
+                std::string first;
+                ss >> first;
+                EdgeUpdate update{-1, -1, 1};
+                if (first == "d") {
+                    update.insert = 0;
+                } else {
+                    ss.clear();
+                    ss.str(line);
+                }
+                int u, v;
+                if (ss >> u >> v) {
+                    update.u = u;
+                    update.v = v;
+                } else {
+                    std::cerr << "Skipping malformed update: " << line << std::endl;
+                }
+                batch.push_back(update);
+            }
+            return !batch.empty();
+        }
+};
+
+class DistributedLDS {
+    private:
+        int rank;
+        int nprocs;
+        int n;
+        int numworkers;
+        int chunk;
+        int offset = 0;
+        int workLoad = 0;
+        double phi;
+        double delta;
+        int levels_per_group;
+
+        std::vector<uintE> levels;
+        std::vector<std::unordered_set<int>> adjacency;
+        std::vector<uint32_t> upCount;
+        std::vector<uint32_t> prevCount;
+        // cached levels of remote neighbours and the owned vertices (local indices) adjacent to them
+        std::unordered_map<int, uintE> ghostLevels;
+        std::unordered_map<int, std::unordered_set<int>> incident;
+
+        std::vector<char> isDirty;
+        std::vector<int> dirty;
+        std::vector<char> isPending;
+        std::vector<int> pending;
+        // (vertex, level) announcements per destination rank
+        std::vector<std::vector<int>> outgoing;
+        std::vector<int> announced;
+
+        uint64_t fixupRounds = 0;
+        uint64_t levelMoves = 0;
+
+        // Same slices as owns(): the last worker also takes the extra vertices (all of them when n < numworkers).
+        int owner(int v) const {
+            return (chunk > 0) ? std::min(v / chunk, numworkers - 1) + 1 : numworkers;
+        }
+
+        bool owns(int v) const {
+            return v >= offset && v < offset + workLoad;
+        }
+
+        uintE levelOf(int v) const {
+            if (owns(v)) {
+                return levels[v - offset];
+            }
+            auto it = ghostLevels.find(v);
+            return it == ghostLevels.end() ? 0 : it->second;
+        }
+
+        // Adds (sign 1) or takes back (sign -1) what a neighbour at level l contributes to the counts of `local`.
+        void count(int local, uintE l, int sign) {
+            uintE level = levels[local];
+            if (l >= level) {
+                upCount[local] += sign;
+            } else if (l + 1 == level) {
+                prevCount[local] += sign;
+            }
+        }
+
+        // A neighbour of `local` went from level `from` to level `to`.
+        void relevel(int local, uintE from, uintE to) {
+            count(local, from, -1);
+            count(local, to, 1);
+            markDirty(local);
+        }
+
+        void markDirty(int local) {
+            if (!isDirty[local]) {
+                isDirty[local] = 1;
+                dirty.push_back(local);
+            }
+        }
+
+        // Sends the level of owned vertex `local` to every other rank owning one of its neighbours.
+        void announce(int local) {
+            std::fill(announced.begin(), announced.end(), 0);
+            for (int ngh : adjacency[local]) {
+                int p = owner(ngh);
+                if (p != rank && !announced[p]) {
+                    announced[p] = 1;
+                    outgoing[p].push_back(offset + local);
+                    outgoing[p].push_back(levels[local]);
+                }
+            }
+        }
+
+        // Collective. Delivers the announcements and updates the counts of the owned neighbours of every moved vertex.
+        void exchange() {
+            std::vector<int> sendBuffer, sendCounts(nprocs), sendDispls(nprocs), recvCounts(nprocs), recvDispls(nprocs);
+            for (int p = 0; p < nprocs; p++) {
+                sendCounts[p] = outgoing[p].size();
+                sendDispls[p] = sendBuffer.size();
+                sendBuffer.insert(sendBuffer.end(), outgoing[p].begin(), outgoing[p].end());
+                outgoing[p].clear();
+            }
+            MPI_Alltoall(sendCounts.data(), 1, MPI_INT, recvCounts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+            int total = 0;
+            for (int p = 0; p < nprocs; p++) {
+                recvDispls[p] = total;
+                total += recvCounts[p];
+            }
+            std::vector<int> recvBuffer(total);
+            MPI_Alltoallv(sendBuffer.data(), sendCounts.data(), sendDispls.data(), MPI_INT,
+                          recvBuffer.data(), recvCounts.data(), recvDispls.data(), MPI_INT, MPI_COMM_WORLD);
+            for (int e = 0; e < total; e += 2) {
+                int v = recvBuffer[e];
+                auto it = incident.find(v);
+                if (it == incident.end()) {
+                    continue;
+                }
+                uintE& cached = ghostLevels[v];
+                uintE from = cached, to = recvBuffer[e + 1];
+                cached = to;
+                if (from == to) {
+                    continue;
+                }
+                for (int local : it->second) {
+                    relevel(local, from, to);
+                }
+            }
+        }
+
+        bool upperInvariant(int local) const {
+            uintE group = levels[local] / levels_per_group;
+            return upCount[local] <= static_cast<size_t>(upper_constant(delta, false) * group_degree(group, phi));
+        }
+
+        bool lowerInvariant(int local) const {
+            if (levels[local] == 0) {
+                return true;
+            }
+            uintE lower_group = (levels[local] - 1) / levels_per_group;
+            return upCount[local] + prevCount[local] >= static_cast<size_t>(group_degree(lower_group, phi));
+        }
+
+        // Queues the dirty vertices whose counts changed into violating an invariant.
+        void queueViolations() {
+            for (int local : dirty) {
+                isDirty[local] = 0;
+                if (!isPending[local] && !(upperInvariant(local) && lowerInvariant(local))) {
+                    isPending[local] = 1;
+                    pending.push_back(local);
+                }
+            }
+            dirty.clear();
+        }
+
+        void move(int local, int step) {
+            uintE from = levels[local];
+            levels[local] += step;
+            levelMoves++;
+            upCount[local] = 0;
+            prevCount[local] = 0;
+            for (int ngh : adjacency[local]) {
+                count(local, levelOf(ngh), 1);
+                if (owns(ngh)) {
+                    relevel(ngh - offset, from, levels[local]);
+                }
+            }
+            markDirty(local);
+            announce(local);
+        }
+
+        // Inserting an edge that is already there changes nothing.
+        void addNeighbor(int local, int ngh) {
+            if (!adjacency[local].insert(ngh).second) {
+                return;
+            }
+            count(local, levelOf(ngh), 1);
+            if (!owns(ngh)) {
+                incident[ngh].insert(local);
+                // the owner of ngh announces its level in the same exchange
+                int p = owner(ngh);
+                outgoing[p].push_back(offset + local);
+                outgoing[p].push_back(levels[local]);
+            }
+            markDirty(local);
+        }
+
+        void removeNeighbor(int local, int ngh) {
+            if (adjacency[local].erase(ngh) == 0) {
+                return;
+            }
+            count(local, levelOf(ngh), -1);
+            if (!owns(ngh)) {
+                std::unordered_set<int>& locals = incident[ngh];
+                locals.erase(local);
+                if (locals.empty()) {
+                    incident.erase(ngh);
+                    ghostLevels.erase(ngh);
+                }
+            }
+            markDirty(local);
+        }
+
+    public:
+        DistributedLDS(int _rank, int _nprocs, int _n, double _phi, double _delta, int _levels_per_group) : rank(_rank), nprocs(_nprocs), n(_n),
+            numworkers(_nprocs - 1), chunk(_n / (_nprocs - 1)), phi(_phi), delta(_delta), levels_per_group(_levels_per_group),
+            outgoing(_nprocs), announced(_nprocs, 0) {
+            if (rank != 0) {
+                offset = (rank - 1) * chunk;
+                workLoad = (rank == numworkers) ? n - offset : chunk;
+            }
+            levels.assign(workLoad, 0);
+            adjacency.resize(workLoad);
+            upCount.assign(workLoad, 0);
+            prevCount.assign(workLoad, 0);
+            isDirty.assign(workLoad, 0);
+            isPending.assign(workLoad, 0);
+        }
+
+        /**
+         * Collective. Routes the batch (only read on the coordinator, which
+         * drops self loops and out-of-range ids) to the owners of both
+         * endpoints, applies it and runs fixup rounds until every invariant
+         * holds again. Returns the number of updates applied.
+        */
+        int applyBatch(const std::vector<EdgeUpdate>& batch) {
+            std::vector<int> sendBuffer, sendCounts(nprocs, 0), sendDispls(nprocs, 0);
+            int applied = 0;
+            if (rank == 0) {
+                std::vector<std::vector<int>> routed(nprocs);
+                for (const EdgeUpdate& update : batch) {
+                    if (update.u == update.v || update.u < 0 || update.v < 0 || update.u >= n || update.v >= n) {
+                        continue;
+                    }
+                    applied++;
+                    int pu = owner(update.u), pv = owner(update.v);
+                    routed[pu].insert(routed[pu].end(), {update.u, update.v, update.insert});
+                    if (pv != pu) {
+                        routed[pv].insert(routed[pv].end(), {update.u, update.v, update.insert});
+                    }
+                }
+                for (int p = 0; p < nprocs; p++) {
+                    sendCounts[p] = routed[p].size();
+                    sendDispls[p] = sendBuffer.size();
+                    sendBuffer.insert(sendBuffer.end(), routed[p].begin(), routed[p].end());
+                }
+            }
+            int count = 0;
+            MPI_Scatter(sendCounts.data(), 1, MPI_INT, &count, 1, MPI_INT, 0, MPI_COMM_WORLD);
+            std::vector<int> updates(count);
+            MPI_Scatterv(sendBuffer.data(), sendCounts.data(), sendDispls.data(), MPI_INT, updates.data(), count, MPI_INT, 0, MPI_COMM_WORLD);
+
+            for (int e = 0; e < count; e += 3) {
+                int u = updates[e], v = updates[e + 1];
+                for (int k = 0; k < 2; k++) {
+                    if (owns(u)) {
+                        if (updates[e + 2]) {
+                            addNeighbor(u - offset, v);
+                        } else {
+                            removeNeighbor(u - offset, v);
+                        }
+                    }
+                    std::swap(u, v);
+                }
+            }
+            fixup();
+            return applied;
+        }
+
+        // Collective. Moves vertices one level per round until no invariant is violated on any rank.
+        void fixup() {
+            while (true) {
+                exchange();
+                queueViolations();
+                // lowest level with an upper violation, minus the highest level with a lower violation
+                int wanted[2] = {INT_MAX, INT_MAX};
+                size_t kept = 0;
+                for (int local : pending) {
+                    if (!upperInvariant(local)) {
+                        wanted[0] = std::min(wanted[0], static_cast<int>(levels[local]));
+                    } else if (!lowerInvariant(local)) {
+                        wanted[1] = std::min(wanted[1], -static_cast<int>(levels[local]));
+                    } else {
+                        isPending[local] = 0;
+                        continue;
+                    }
+                    pending[kept++] = local;
+                }
+                pending.resize(kept);
+                MPI_Allreduce(MPI_IN_PLACE, wanted, 2, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+                if (wanted[0] == INT_MAX && wanted[1] == INT_MAX) {
+                    break;
+                }
+                fixupRounds++;
+                bool up = wanted[0] != INT_MAX;
+                uintE level = up ? wanted[0] : -wanted[1];
+                for (int local : pending) {
+                    if (levels[local] != level) {
+                        continue;
+                    }
+                    if (up && !upperInvariant(local)) {
+                        move(local, 1);
+                    } else if (!up && !lowerInvariant(local)) {
+                        move(local, -1);
+                    }
+                }
+            }
+        }
+
+        // Collective. Returns every vertex's level on the coordinator (empty elsewhere).
+        std::vector<uintE> gatherLevels() {
+            std::vector<int> counts(nprocs), displs(nprocs, 0);
+            MPI_Gather(&workLoad, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+            std::vector<uintE> all;
+            if (rank == 0) {
+                for (int p = 1; p < nprocs; p++) {
+                    displs[p] = displs[p - 1] + counts[p - 1];
+                }
+                all.resize(n);
+            }
+            MPI_Gatherv(levels.data(), workLoad, MPI_UNSIGNED, all.data(), counts.data(), displs.data(), MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+            return all;
+        }
+
+        // Same estimate as LDS_approx.h: drop to the previous group unless at its top level.
+        double coreNumber(uintE level) const {
+            uintE group = level / levels_per_group;
+            if (level % levels_per_group != static_cast<uintE>(levels_per_group - 1) && group != 0) {
+                group--;
+            }
+            return ceil(group_degree(group, phi));
+        }
+
+        uint64_t getFixupRounds() const {
+            return fixupRounds;
+        }
+
+        uint64_t getLevelMoves() const {
+            return levelMoves;
+        }
+};
+
+struct StreamStats {
+    uint64_t updates = 0;
+    uint64_t dropped = 0;
+    int batches = 0;
+    double seconds = 0.0;
+    double p50 = 0.0;
+    double p99 = 0.0;
+    uint64_t fixupRounds = 0;
+    uint64_t levelMoves = 0;
+};
+
+/**
+ * Collective. Feeds batches from next(batch) (called on the coordinator only,
+ * returns false once exhausted) through lds until the stream ends. The stats
+ * are complete on the coordinator: latency covers routing and fixup of a
+ * batch, throughput the whole run including reading the stream.
+*/
+template <class F>
+StreamStats runStream(DistributedLDS& lds, int rank, F next) {
+    StreamStats stats;
+    std::vector<double> latencies;
+    std::vector<EdgeUpdate> batch;
+    auto start = std::chrono::high_resolution_clock::now();
+    while (true) {
+        int more = 0;
+        batch.clear();
+        if (rank == 0) {
+            more = next(batch) ? 1 : 0;
+        }
+        MPI_Bcast(&more, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        if (!more) {
+            break;
+        }
+        auto batch_start = std::chrono::high_resolution_clock::now();
+        int applied = lds.applyBatch(batch);
+        std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - batch_start;
+        latencies.push_back(elapsed.count());
+        stats.updates += applied;
+        stats.dropped += batch.size() - applied;
+        stats.batches++;
+    }
+    std::chrono::duration<double> total = std::chrono::high_resolution_clock::now() - start;
+    stats.seconds = total.count();
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        stats.p50 = latencies[(latencies.size() - 1) / 2];
+        stats.p99 = latencies[std::min(latencies.size() - 1, static_cast<size_t>(ceil(0.99 * latencies.size())) - 1)];
+    }
+    stats.fixupRounds = lds.getFixupRounds();
+    unsigned long long moves = lds.getLevelMoves(), totalMoves = 0;
+    MPI_Reduce(&moves, &totalMoves, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    stats.levelMoves = totalMoves;
+    return stats;
+}
+
+inline void printStreamStats(const StreamStats& stats) {
+    std::cerr << "Stream Updates: " << stats.updates << " (batches: " << stats.batches << ", dropped: " << stats.dropped << ")" << std::endl;
+    std::cerr << "Stream Throughput: " << stats.updates / std::max(stats.seconds, 1e-9) << " updates/sec" << std::endl;
+    std::cerr << "Batch Latency: p50 " << stats.p50 << " p99 " << stats.p99 << std::endl;
+    std::cerr << "Fixup Rounds: " << stats.fixupRounds << " (level moves: " << stats.levelMoves << ")" << std::endl;
+}
+
+} // end of namespace distributed_kcore
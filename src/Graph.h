@@ -1,20 +1,64 @@
 
+#pragma once
+
 #include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <string>
-#include <set>
 #include <unordered_map>
+#include <algorithm>
+#include "CompressedAdjacency.h"
+#include "HugePages.h"
+#include "IdTypes.h"
 
 
 namespace distributed_kcore{
 
-class Graph {
+// Lightweight view over one vertex's neighbours in the CSR arrays.
+template <class V>
+struct NeighborRangeT {
+    const V* first;
+    const V* last;
+
+    const V* begin() const { return first; }
+    const V* end() const { return last; }
+    size_t size() const { return last - first; }
+};
+
+/**
+ * V is the vertex ID type (adjacency entries, slice bounds, degree map keys),
+ * E the type of edge offsets and counts.
+*/
+template <class V, class E>
+class GraphT {
     private:
-        std::unordered_map<int, std::vector<int>> adjacenyList;
-        std::unordered_map<int, int> nodeDegrees;
-        size_t graphSize = 0;
+        // Worker slice [sliceOffset, sliceOffset + sliceSize) in CSR form:
+        // the neighbours of vertex v are adjacency[adjOffsets[v - sliceOffset] .. adjOffsets[v - sliceOffset + 1])
+        V sliceOffset = 0;
+        V sliceSize = 0;
+        std::vector<E, PageAllocator<E>> adjOffsets;
+        std::vector<V, PageAllocator<V>> adjacency;
+        // what getNeighbors() reads: the two vectors above, or CSR arrays owned elsewhere (see view())
+        const E* offsetsData = nullptr;
+        const V* adjacencyData = nullptr;
+        E numEntries = 0;
+        // after compress(): the list of v starts at compressedBytes[byteOffsets[v - sliceOffset]]; it is
+        // decoded into a buffer of at least maxListLength entries, `decoded` for getNeighbors(v)
+        std::vector<E, PageAllocator<E>> byteOffsets;
+        std::vector<uint8_t, PageAllocator<uint8_t>> compressedBytes;
+        size_t maxListLength = 0;
+        std::vector<V> decoded;
+        // after sparsify(): (slice index, degree before sampling) of the vertices whose list was cut, by index
+        std::vector<std::pair<V, V>> sampledDegrees;
+        bool sparsified = false;
+        // (vertex, ngh) pairs collected while loading, compacted by finalize()
+        std::vector<std::pair<V, V>> pendingEdges;
+        std::unordered_map<V, E> nodeDegrees;
+        E graphSize = 0;
 
         std::vector<std::string> splitString(const std::string& line, char del) {
 			std::vector<std::string> result;
@@ -26,116 +70,427 @@ class Graph {
 			}
 			return result;
 		}
-    
-    public:
-        Graph(const std::string& filename) {
-            std::ifstream file(filename);
+
+        /**
+         * Calls f(vertex, ngh) for every edge in the file. Files starting with
+         * kBinaryMagic are read as the binary edge list written by writeBinary(),
+         * anything else as one "vertex ngh" pair per line.
+        */
+        template <class F>
+        bool forEachEdge(const std::string& filename, F f) {
+            std::ifstream file(filename, std::ios::binary);
             if (!file.is_open()) {
                 std::cerr << "Failed to open file: " << filename << std::endl;
-                return;
+                return false;
             }
+            char magic[sizeof(kBinaryMagic)] = {0};
+            file.read(magic, sizeof(magic));
+            if (file.gcount() == sizeof(magic) && std::memcmp(magic, kBinaryMagic, sizeof(magic)) == 0) {
+                uint64_t numEdges = 0;
+                file.read(reinterpret_cast<char*>(&numEdges), sizeof(numEdges));
+                std::vector<uint32_t> block;
+                const uint64_t blockEdges = 1 << 20;
+                for (uint64_t done = 0; done < numEdges; done += blockEdges) {
+                    uint64_t count = std::min(blockEdges, numEdges - done);
+                    block.resize(2 * count);
+                    file.read(reinterpret_cast<char*>(block.data()), block.size() * sizeof(uint32_t));
+                    for (uint64_t e = 0; e < count; e++) {
+                        f(static_cast<V>(block[2 * e]), static_cast<V>(block[2 * e + 1]));
+                    }
+                }
+                file.close();
+                return true;
+            }
+            file.clear();
+            file.seekg(0);
             std::string line;
             while (std::getline(file, line)) {
                 std::vector<std::string> values = splitString(line, ' ');
-                std::vector<int> neighbors1;
-                std::vector<int> neighbors2;
                 // to ensure that its zero indexed
-                int vertex = std::stoi(values[0]);
-                int ngh = std::stoi(values[1]);
-                // if (adjacenyList.find(vertex) == adjacenyList.end()) {
-                if (nodeDegrees.find(vertex) == nodeDegrees.end()) {
-                    // adjacenyList[vertex] = neighbors1;
-                    nodeDegrees[vertex] = 0;
-                }
-                // if (adjacenyList.find(ngh) == adjacenyList.end()) {
-                if (nodeDegrees.find(vertex) == nodeDegrees.end()) {
-                    // adjacenyList[ngh] = neighbors2;
-                    nodeDegrees[ngh] = 0;
-                }
-                // adjacenyList[vertex].push_back(ngh);
-                // adjacenyList[ngh].push_back(vertex);
-                nodeDegrees[vertex]++;
-                nodeDegrees[ngh]++;
+                f(static_cast<V>(std::stoll(values[0])), static_cast<V>(std::stoll(values[1])));
             }
             file.close();
-            graphSize = adjacenyList.size();   
+            return true;
         }
 
-        Graph(const std::string& filename, int offset, int workLoad) {
-            std::ifstream file(filename);
-            std::set<int> workingNodes;
-            int end_node = offset + workLoad;
-            for (int i = offset; i < end_node; i++) {
-                workingNodes.insert(i);
+        void addDegrees(V vertex, V ngh) {
+            // if (adjacenyList.find(vertex) == adjacenyList.end()) {
+            if (nodeDegrees.find(vertex) == nodeDegrees.end()) {
+                // adjacenyList[vertex] = neighbors1;
+                nodeDegrees[vertex] = 0;
+            }
+            // if (adjacenyList.find(ngh) == adjacenyList.end()) {
+            if (nodeDegrees.find(vertex) == nodeDegrees.end()) {
+                // adjacenyList[ngh] = neighbors2;
+                nodeDegrees[ngh] = 0;
             }
+            // adjacenyList[vertex].push_back(ngh);
+            // adjacenyList[ngh].push_back(vertex);
+            nodeDegrees[vertex]++;
+            nodeDegrees[ngh]++;
+        }
 
-            if (!file.is_open()) {
+        bool inSlice(V vertex) const {
+            return vertex >= sliceOffset && vertex < sliceOffset + sliceSize;
+        }
+
+        GraphT() {}
+
+    public:
+        static constexpr char kBinaryMagic[4] = {'K', 'C', 'B', 'G'};
+
+        GraphT(const std::string& filename) {
+            forEachEdge(filename, [&](V vertex, V ngh) { addDegrees(vertex, ngh); });
+        }
+
+        GraphT(const std::string& filename, V offset, V workLoad) : sliceOffset(offset), sliceSize(workLoad) {
+            forEachEdge(filename, [&](V vertex, V ngh) { addEdge(vertex, ngh); });
+            finalize();
+        }
+
+        // In-memory equivalents of the two file constructors (synthetic graphs, benchmarks)
+        template <class I>
+        GraphT(const std::vector<std::pair<I, I>>& edges) {
+            for (const auto& edge : edges) {
+                addDegrees(edge.first, edge.second);
+            }
+        }
+
+        template <class I>
+        GraphT(const std::vector<std::pair<I, I>>& edges, V offset, V workLoad) : sliceOffset(offset), sliceSize(workLoad) {
+            for (const auto& edge : edges) {
+                addEdge(edge.first, edge.second);
+            }
+            finalize();
+        }
+
+        // Empty slice to be filled with addEdge() and closed with finalize().
+        GraphT(V offset, V workLoad) : sliceOffset(offset), sliceSize(workLoad) {}
+
+        // Coordinator-side graph that only knows the degrees of vertices 0..n-1.
+        template <class D>
+        static GraphT* fromDegrees(const std::vector<D>& degrees) {
+            GraphT* graph = new GraphT();
+            for (size_t node = 0; node < degrees.size(); node++) {
+                graph->nodeDegrees[node] = degrees[node];
+            }
+            return graph;
+        }
+
+        /**
+         * Slice backed by CSR arrays the caller keeps alive (e.g. in shared
+         * memory): the neighbours of v are adjacency[offsets[v - offset] .. offsets[v - offset + 1]).
+        */
+        static GraphT* view(V offset, V workLoad, const E* offsets, const V* adjacency) {
+            GraphT* graph = new GraphT(offset, workLoad);
+            graph->offsetsData = offsets;
+            graph->adjacencyData = adjacency;
+            graph->numEntries = workLoad > 0 ? offsets[workLoad] - offsets[0] : 0;
+            for (V i = 0; i < workLoad; i++) {
+                graph->graphSize += (offsets[i + 1] != offsets[i]);
+            }
+            return graph;
+        }
+
+        // Adds the undirected edge to the adjacency of whichever endpoints are in the slice.
+        void addEdge(V vertex, V ngh) {
+            if (inSlice(vertex)) {
+                pendingEdges.emplace_back(vertex, ngh);
+            }
+            if (inSlice(ngh)) {
+                pendingEdges.emplace_back(ngh, vertex);
+            }
+        }
+
+        // Adds only the vertex -> ngh direction (edges already routed to the owner of vertex).
+        void addDirectedEdge(V vertex, V ngh) {
+            if (inSlice(vertex)) {
+                pendingEdges.emplace_back(vertex, ngh);
+            }
+        }
+
+        // Counting sort of the pending edges into CSR; neighbours keep their input order.
+        void finalize() {
+            adjOffsets.assign(sliceSize + 1, 0);
+            for (const auto& edge : pendingEdges) {
+                adjOffsets[edge.first - sliceOffset + 1]++;
+            }
+            for (V i = 0; i < sliceSize; i++) {
+                adjOffsets[i + 1] += adjOffsets[i];
+            }
+            adjacency.resize(pendingEdges.size());
+            std::vector<E> cursor(adjOffsets.begin(), adjOffsets.end() - 1);
+            for (const auto& edge : pendingEdges) {
+                adjacency[cursor[edge.first - sliceOffset]++] = edge.second;
+            }
+            pendingEdges.clear();
+            pendingEdges.shrink_to_fit();
+            offsetsData = adjOffsets.data();
+            adjacencyData = adjacency.data();
+            numEntries = adjacency.size();
+            graphSize = 0;
+            for (V i = 0; i < sliceSize; i++) {
+                graphSize += (adjOffsets[i + 1] != adjOffsets[i]);
+            }
+        }
+
+        // Binary edge list: magic, uint64 edge count, then (uint32, uint32) pairs.
+        template <class I>
+        static bool writeBinary(const std::string& filename, const std::vector<std::pair<I, I>>& edges) {
+            std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
                 std::cerr << "Failed to open file: " << filename << std::endl;
-                return;
+                return false;
             }
-            std::string line;
-            while (std::getline(file, line)) {
-                std::vector<std::string> values = splitString(line, ' ');
-                std::vector<int> neighbors1;
-                std::vector<int> neighbors2;
-                // to ensure that its zero indexed
-                int vertex = std::stoi(values[0]);
-                int ngh = std::stoi(values[1]);
-                if (workingNodes.find(vertex) != workingNodes.end()) {
-                    if (adjacenyList.find(vertex) == adjacenyList.end()) {
-                        adjacenyList[vertex] = neighbors1;
-                    }
-                    adjacenyList[vertex].push_back(ngh);
+            uint64_t numEdges = edges.size();
+            out.write(kBinaryMagic, sizeof(kBinaryMagic));
+            out.write(reinterpret_cast<const char*>(&numEdges), sizeof(numEdges));
+            for (const auto& edge : edges) {
+                uint32_t pair[2] = {static_cast<uint32_t>(edge.first), static_cast<uint32_t>(edge.second)};
+                out.write(reinterpret_cast<const char*>(pair), sizeof(pair));
+            }
+            return static_cast<bool>(out);
+        }
+
+        // Appends the degrees and the concatenated lists of [from, to) (within the slice).
+        void appendLists(V from, V to, std::vector<E>& degrees, std::vector<V>& lists) const {
+            std::vector<V> buffer;
+            for (V v = from; v < to; v++) {
+                NeighborRangeT<V> neighbors = getNeighbors(v, buffer);
+                degrees.push_back(neighbors.size());
+                lists.insert(lists.end(), neighbors.begin(), neighbors.end());
+            }
+        }
+
+        /**
+         * Moves an uncompressed, self-owned slice to [offset, offset + workLoad).
+         * The vertices in front of the current slice come as beforeDegrees /
+         * beforeLists (in appendLists() form), those behind it as afterDegrees /
+         * afterLists; vertices of the current slice outside the new one are dropped.
+        */
+        void reslice(V offset, V workLoad, const std::vector<E>& beforeDegrees, const std::vector<V>& beforeLists,
+                const std::vector<E>& afterDegrees, const std::vector<V>& afterLists) {
+            V keepFrom = std::max(offset, sliceOffset);
+            V keepTo = std::min(offset + workLoad, sliceOffset + sliceSize);
+            std::vector<E, PageAllocator<E>> offsets;
+            std::vector<V, PageAllocator<V>> lists;
+            offsets.reserve(workLoad + 1);
+            offsets.push_back(0);
+            for (E degree : beforeDegrees) {
+                offsets.push_back(offsets.back() + degree);
+            }
+            lists.insert(lists.end(), beforeLists.begin(), beforeLists.end());
+            for (V v = keepFrom; v < keepTo; v++) {
+                NeighborRangeT<V> neighbors = getNeighbors(v);
+                offsets.push_back(offsets.back() + neighbors.size());
+                lists.insert(lists.end(), neighbors.begin(), neighbors.end());
+            }
+            for (E degree : afterDegrees) {
+                offsets.push_back(offsets.back() + degree);
+            }
+            lists.insert(lists.end(), afterLists.begin(), afterLists.end());
+            adjOffsets.swap(offsets);
+            adjacency.swap(lists);
+            sliceOffset = offset;
+            sliceSize = workLoad;
+            offsetsData = adjOffsets.data();
+            adjacencyData = adjacency.data();
+            numEntries = adjacency.size();
+            graphSize = 0;
+            for (V i = 0; i < sliceSize; i++) {
+                graphSize += (adjOffsets[i + 1] != adjOffsets[i]);
+            }
+        }
+
+        /**
+         * Replaces the CSR of a slice built by this object with sorted,
+         * group-varint coded lists (see CompressedAdjacency.h). Returns false
+         * and keeps the CSR for a view() or if two neighbours are 2^32 or
+         * more apart.
+        */
+        bool compress() {
+            if (isCompressed() || adjacencyData != adjacency.data() || sliceSize == 0) {
+                return false;
+            }
+            std::vector<E, PageAllocator<E>> offsets(sliceSize + 1, 0);
+            std::vector<uint8_t, PageAllocator<uint8_t>> bytes;
+            std::vector<V> sorted;
+            size_t maxDegree = 0;
+            for (V i = 0; i < sliceSize; i++) {
+                offsets[i] = bytes.size();
+                sorted.assign(adjacency.begin() + adjOffsets[i], adjacency.begin() + adjOffsets[i + 1]);
+                std::sort(sorted.begin(), sorted.end());
+                if (!encodeNeighbors(sorted.data(), sorted.size(), bytes)) {
+                    return false;
                 }
+                maxDegree = std::max(maxDegree, sorted.size());
+            }
+            offsets[sliceSize] = bytes.size();
+            bytes.resize(bytes.size() + kDecodePadding, 0);
+            bytes.shrink_to_fit();
+            byteOffsets.swap(offsets);
+            compressedBytes.swap(bytes);
+            maxListLength = maxDegree;
+            decoded.resize(maxDegree);
+            std::vector<E, PageAllocator<E>>().swap(adjOffsets);
+            std::vector<V, PageAllocator<V>>().swap(adjacency);
+            offsetsData = nullptr;
+            adjacencyData = nullptr;
+            return true;
+        }
 
-                if (workingNodes.find(ngh) != workingNodes.end()) {
-                    if (adjacenyList.find(ngh) == adjacenyList.end()) {
-                        adjacenyList[ngh] = neighbors2;
-                    }
-                    adjacenyList[ngh].push_back(vertex);
+        bool isCompressed() const {
+            return !byteOffsets.empty();
+        }
+
+        // Degree before sampling of a slice vertex whose list sparsify() cut, nullptr for any other vertex.
+        const V* sampledDegree(V node) const {
+            if (sampledDegrees.empty() || !inSlice(node)) {
+                return nullptr;
+            }
+            V index = node - sliceOffset;
+            auto it = std::lower_bound(sampledDegrees.begin(), sampledDegrees.end(), index,
+                    [](const std::pair<V, V>& entry, V key) { return entry.first < key; });
+            return (it != sampledDegrees.end() && it->first == index) ? &it->second : nullptr;
+        }
+
+        /**
+         * Replaces every list of a slice built by this object (uncompressed)
+         * with the neighbours select(v, neighbors, kept) appends to kept,
+         * compacting the CSR in place, and remembers the full degree of each
+         * vertex that lost neighbours (getFullNeighborCount, getNeighborScale).
+         * Returns false and changes nothing for a view() or a compressed slice.
+        */
+        template <class Select>
+        bool sparsify(Select select) {
+            if (isCompressed() || adjacencyData != adjacency.data() || sparsified) {
+                return false;
+            }
+            sparsified = true;
+            std::vector<V> kept;
+            E write = 0;
+            E begin = adjOffsets[0];
+            for (V i = 0; i < sliceSize; i++) {
+                E end = adjOffsets[i + 1];
+                NeighborRangeT<V> neighbors{adjacency.data() + begin, adjacency.data() + end};
+                kept.clear();
+                select(sliceOffset + i, neighbors, kept);
+                if (kept.size() < neighbors.size()) {
+                    sampledDegrees.emplace_back(i, static_cast<V>(neighbors.size()));
                 }
+                // kept is a subsequence of the list, so it never overtakes the lists still to be read
+                std::copy(kept.begin(), kept.end(), adjacency.begin() + write);
+                write += kept.size();
+                adjOffsets[i + 1] = write;
+                begin = end;
             }
-            file.close();
-            graphSize = adjacenyList.size();
-            workingNodes.clear(); 
+            adjacency.resize(write);
+            adjacency.shrink_to_fit();
+            sampledDegrees.shrink_to_fit();
+            offsetsData = adjOffsets.data();
+            adjacencyData = adjacency.data();
+            numEntries = adjacency.size();
+            return true;
+        }
+
+        // True if sparsify() cut at least one list of this slice.
+        bool isSparsified() const {
+            return !sampledDegrees.empty();
         }
 
-        std::unordered_map<int, std::vector<int>> getAdjacencyList() {
-            return adjacenyList;
+        // Degree of a slice vertex before sparsify() (getNeighborCount() otherwise).
+        size_t getFullNeighborCount(V node) const {
+            const V* full = sampledDegree(node);
+            return (full != nullptr) ? *full : getNeighborCount(node);
+        }
+
+        // Full over kept degree: what a count over the kept neighbours is scaled by.
+        double getNeighborScale(V node) const {
+            const V* full = sampledDegree(node);
+            size_t kept = getNeighborCount(node);
+            return (full != nullptr && kept > 0) ? static_cast<double>(*full) / kept : 1.0;
+        }
+
+        // Bytes held by this slice's neighbour lists (CSR or compressed, offsets and sampled degrees included).
+        size_t adjacencyBytes() const {
+            size_t full = sampledDegrees.size() * sizeof(std::pair<V, V>);
+            if (isCompressed()) {
+                return byteOffsets.size() * sizeof(E) + compressedBytes.size() + full;
+            }
+            return (sliceSize + 1) * sizeof(E) + numEntries * sizeof(V) + full;
+        }
+
+        // Degree of a slice vertex without decoding its list; safe to call concurrently.
+        size_t getNeighborCount(V node) const {
+            if (!inSlice(node)) {
+                return 0;
+            }
+            if (isCompressed()) {
+                return encodedCount(compressedBytes.data() + byteOffsets[node - sliceOffset]);
+            }
+            return offsetsData[node - sliceOffset + 1] - offsetsData[node - sliceOffset];
         }
 
-        std::vector<int> getNeighbors(int node) {
-            return adjacenyList[node];
+        /**
+         * Neighbours of node. On a compressed slice the list is decoded into a
+         * buffer of the graph, so the range is only valid until the next call
+         * and one thread at a time may iterate; const callers and threads pass
+         * their own buffer to the overload below. Use getNeighborCount() when
+         * only the size is needed.
+        */
+        NeighborRangeT<V> getNeighbors(V node) {
+            return getNeighbors(node, decoded);
         }
 
-        std::unordered_map<int, int> getNodeDegrees() {
+        // As above, decoding (on a compressed slice) into buffer, which is grown as needed.
+        NeighborRangeT<V> getNeighbors(V node, std::vector<V>& buffer) const {
+            if (!inSlice(node)) {
+                return NeighborRangeT<V>{nullptr, nullptr};
+            }
+            if (isCompressed()) {
+                if (buffer.size() < maxListLength) {
+                    buffer.resize(maxListLength);
+                }
+                size_t count = decodeNeighbors(compressedBytes.data() + byteOffsets[node - sliceOffset], buffer.data());
+                return NeighborRangeT<V>{buffer.data(), buffer.data() + count};
+            }
+            return NeighborRangeT<V>{adjacencyData + offsetsData[node - sliceOffset], adjacencyData + offsetsData[node - sliceOffset + 1]};
+        }
+
+        V getSliceOffset() const {
+            return sliceOffset;
+        }
+
+        V getSliceSize() const {
+            return sliceSize;
+        }
+
+        std::unordered_map<V, E> getNodeDegrees() {
             return nodeDegrees;
         }
 
-        int getNodeDegree(int node) {
+        E getNodeDegree(V node) {
             return nodeDegrees[node];
         }
 
-        size_t getGraphSize() {
+        E getGraphSize() {
             return graphSize;
         }
 
-        int sumAdjList() {
-            int sum = 0;
-            for (auto it : adjacenyList) {
-                sum += it.second.size();
-            }
-            return sum;
+        E sumAdjList() {
+            return numEntries;
         }
 
         void printDegrees() {
-            std::unordered_map<int, std::vector<int>>::iterator it;
-            for (it = adjacenyList.begin(); it != adjacenyList.end(); it++) {
-                int node = it->first;
-                std::vector<int> nghs = it->second;
-                std::cout << "Node: " << node << " | Degree : " << nghs.size() << std::endl;
+            for (V node = sliceOffset; node < sliceOffset + sliceSize; node++) {
+                if (getNeighborCount(node) > 0) {
+                    std::cout << "Node: " << node << " | Degree : " << getNeighborCount(node) << std::endl;
+                }
             }
         }
 };
 
+typedef GraphT<vertex_t, edge_t> Graph;
+typedef NeighborRangeT<vertex_t> NeighborRange;
+
 } // end of namespace distributed_kcore
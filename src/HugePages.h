@@ -0,0 +1,178 @@
+/**
+ * @file HugePages.h
+ * @brief Page-aware allocation for the CSR and level arrays
+ *
+ * Arrays of at least one huge page (2 MiB) are mapped directly and 2 MiB
+ * aligned. Under --huge-pages=thp the mapping is madvise(MADV_HUGEPAGE)d;
+ * under --huge-pages=explicit it is first tried with MAP_HUGETLB (which needs
+ * reserved pages, see /proc/sys/vm/nr_hugepages) and falls back to the THP
+ * mapping. Smaller arrays go through operator new.
+ *
+ * Every rank fills its own arrays when it builds them (std::vector value
+ * initialisation, Graph::finalize), so with ranks bound to a socket
+ * (mpirun --bind-to socket or core) the pages are first touched, and
+ * placed, on that socket's memory.
+*/
+
+#pragma once
+
+#include <mpi.h>
+#include <sys/mman.h>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+
+namespace distributed_kcore {
+
+enum PagePolicy {
+    PAGES_DEFAULT,
+    PAGES_TRANSPARENT,
+    PAGES_EXPLICIT
+};
+
+inline bool parsePagePolicy(const std::string& name, PagePolicy& policy) {
+    if (name == "off") {
+        policy = PAGES_DEFAULT;
+    } else if (name == "thp") {
+        policy = PAGES_TRANSPARENT;
+    } else if (name == "explicit") {
+        policy = PAGES_EXPLICIT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static constexpr size_t kHugePageSize = size_t(2) << 20;
+
+// Set once from the command line, before the graph is loaded.
+inline PagePolicy& pagePolicy() {
+    static PagePolicy policy = PAGES_DEFAULT;
+    return policy;
+}
+
+struct PageStats {
+    std::atomic<unsigned long long> mappedBytes{0};
+    std::atomic<unsigned long long> hugetlbBytes{0};
+    std::atomic<unsigned long long> fallbacks{0};
+};
+
+inline PageStats& pageStats() {
+    static PageStats stats;
+    return stats;
+}
+
+inline size_t roundToHugePage(size_t bytes) {
+    return (bytes + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+}
+
+// Anonymous mapping of bytes (a multiple of kHugePageSize) aligned to kHugePageSize.
+inline void* mapAligned(size_t bytes) {
+    void* raw = mmap(nullptr, bytes + kHugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t aligned = (start + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+    if (aligned > start) {
+        munmap(raw, aligned - start);
+    }
+    if (start + kHugePageSize > aligned) {
+        munmap(reinterpret_cast<void*>(aligned + bytes), start + kHugePageSize - aligned);
+    }
+    return reinterpret_cast<void*>(aligned);
+}
+
+inline void* allocatePages(size_t bytes) {
+    if (bytes < kHugePageSize) {
+        return ::operator new(bytes);
+    }
+    size_t mapped = roundToHugePage(bytes);
+    pageStats().mappedBytes += mapped;
+    if (pagePolicy() == PAGES_EXPLICIT) {
+        void* p = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            pageStats().hugetlbBytes += mapped;
+            return p;
+        }
+        pageStats().fallbacks++;
+    }
+    void* p = mapAligned(mapped);
+    if (pagePolicy() != PAGES_DEFAULT) {
+        madvise(p, mapped, MADV_HUGEPAGE);
+    }
+    return p;
+}
+
+inline void freePages(void* p, size_t bytes) {
+    if (bytes < kHugePageSize) {
+        ::operator delete(p);
+        return;
+    }
+    munmap(p, roundToHugePage(bytes));
+}
+
+// std::allocator replacement for the vectors behind the CSR and the level arrays.
+template <class T>
+struct PageAllocator {
+    typedef T value_type;
+
+    PageAllocator() = default;
+
+    template <class U>
+    PageAllocator(const PageAllocator<U>&) {}
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(allocatePages(count * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t count) {
+        freePages(p, count * sizeof(T));
+    }
+};
+
+template <class T, class U>
+bool operator==(const PageAllocator<T>&, const PageAllocator<U>&) {
+    return true;
+}
+
+template <class T, class U>
+bool operator!=(const PageAllocator<T>&, const PageAllocator<U>&) {
+    return false;
+}
+
+// AnonHugePages of this process in bytes (transparent huge pages actually in use), 0 if unknown.
+inline unsigned long long transparentHugeBytes() {
+    std::ifstream in("/proc/self/smaps_rollup");
+    std::string key;
+    unsigned long long kb;
+    while (in >> key) {
+        if (key == "AnonHugePages:" && (in >> kb)) {
+            return kb * 1024;
+        }
+        in.ignore(1 << 20, '\n');
+    }
+    return 0;
+}
+
+/**
+ * Collective. Prints, on the coordinator, the page policy and the bytes
+ * summed over all ranks: mapped by PageAllocator, backed by MAP_HUGETLB and
+ * backed by transparent huge pages (whole process), plus MAP_HUGETLB fallbacks.
+*/
+inline void reportPages(int rank, int coordinator) {
+    unsigned long long local[4] = {pageStats().mappedBytes, pageStats().hugetlbBytes, transparentHugeBytes(), pageStats().fallbacks};
+    unsigned long long sum[4] = {0, 0, 0, 0};
+    MPI_Reduce(local, sum, 4, MPI_UNSIGNED_LONG_LONG, MPI_SUM, coordinator, MPI_COMM_WORLD);
+    if (rank == coordinator) {
+        static const char* const kNames[] = {"off", "thp", "explicit"};
+        std::cerr << "Huge Pages: " << kNames[pagePolicy()] << " (mapped " << sum[0] << " bytes, hugetlb " << sum[1]
+                  << " bytes, transparent " << sum[2] << " bytes, hugetlb fallbacks " << sum[3] << ")" << std::endl;
+    }
+}
+
+} // end of namespace distributed_kcore
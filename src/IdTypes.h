@@ -0,0 +1,87 @@
+/**
+ * @file IdTypes.h
+ * @brief Vertex and edge ID types, and MPI transfers that do not overflow int counts
+ *
+ * Vertex IDs are 32-bit unless built with KCORE_64BIT_IDS (cmake
+ * -DKCORE_64BIT_IDS=ON); edge offsets and counts are always 64-bit. Graph,
+ * LDS and KCore_compute are templates over these types and the aliases below
+ * pick the build's instantiation.
+*/
+
+#pragma once
+
+#include <mpi.h>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <limits>
+
+namespace distributed_kcore {
+
+#ifdef KCORE_64BIT_IDS
+typedef int64_t vertex_t;
+#else
+typedef int32_t vertex_t;
+#endif
+typedef uint64_t edge_t;
+
+template <class T> struct MpiType;
+template <> struct MpiType<int32_t> { static MPI_Datatype get() { return MPI_INT32_T; } };
+template <> struct MpiType<int64_t> { static MPI_Datatype get() { return MPI_INT64_T; } };
+template <> struct MpiType<uint32_t> { static MPI_Datatype get() { return MPI_UINT32_T; } };
+template <> struct MpiType<uint64_t> { static MPI_Datatype get() { return MPI_UINT64_T; } };
+template <> struct MpiType<uint8_t> { static MPI_Datatype get() { return MPI_UINT8_T; } };
+template <> struct MpiType<uint16_t> { static MPI_Datatype get() { return MPI_UINT16_T; } };
+
+// Largest element count handed to a single MPI call by the chunked transfers below.
+static constexpr size_t kMpiChunk = size_t(1) << 30;
+
+/**
+ * Point-to-point transfer of count elements in pieces of at most kMpiChunk,
+ * so arrays of 2^31 elements or more go through int-count MPI calls. Both
+ * sides must use the same count.
+*/
+template <class T>
+void sendChunked(const T* data, size_t count, int dest, int tag, MPI_Comm comm) {
+    size_t done = 0;
+    do {
+        size_t piece = std::min(kMpiChunk, count - done);
+        MPI_Send(data + done, static_cast<int>(piece), MpiType<T>::get(), dest, tag, comm);
+        done += piece;
+    } while (done < count);
+}
+
+template <class T>
+void recvChunked(T* data, size_t count, int source, int tag, MPI_Comm comm) {
+    size_t done = 0;
+    do {
+        size_t piece = std::min(kMpiChunk, count - done);
+        MPI_Recv(data + done, static_cast<int>(piece), MpiType<T>::get(), source, tag, comm, MPI_STATUS_IGNORE);
+        done += piece;
+    } while (done < count);
+}
+
+// Non-blocking sendChunked / recvChunked: appends one request per piece.
+template <class T>
+void isendChunked(std::vector<MPI_Request>& requests, const T* data, size_t count, int dest, int tag, MPI_Comm comm) {
+    size_t done = 0;
+    do {
+        size_t piece = std::min(kMpiChunk, count - done);
+        requests.emplace_back();
+        MPI_Isend(data + done, static_cast<int>(piece), MpiType<T>::get(), dest, tag, comm, &requests.back());
+        done += piece;
+    } while (done < count);
+}
+
+template <class T>
+void irecvChunked(std::vector<MPI_Request>& requests, T* data, size_t count, int source, int tag, MPI_Comm comm) {
+    size_t done = 0;
+    do {
+        size_t piece = std::min(kMpiChunk, count - done);
+        requests.emplace_back();
+        MPI_Irecv(data + done, static_cast<int>(piece), MpiType<T>::get(), source, tag, comm, &requests.back());
+        done += piece;
+    } while (done < count);
+}
+
+} // end of namespace distributed_kcore
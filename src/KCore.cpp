@@ -3,190 +3,12 @@
  * @brief Approximate KCore Distributed Algorithm
 */
 
-#include <math.h>
-#include <mpi.h>
-#include <vector>
-#include <string>
-#include <set>
-#include <unordered_map>
-#include <chrono>
-#include "LDS.h"
-#include "Graph.h"
-#include "distributions.h"
-
-#define COORDINATOR 0 
-#define FROM_MASTER 1
-#define FROM_WORKER 2
-
-namespace distributed_kcore {
-
-
-int log_a_to_base_b(int a, double b) {
-    // log_b a = log_2 a / log_2 b
-    return log2(a) / log2(b);
-}
-
-LDS* KCore_compute(int rank, int nprocs, Graph* graph, double eta, double epsilon, double phi, double lambda, int levels_per_group, double factor, int bias, int bias_factor, int n) {
-    double delta = 9.0;
-    double rounds_param = ceil(4.0 * pow(log_a_to_base_b(n, 1.0 + phi), 1.5));
-    int number_of_rounds = static_cast<int>(rounds_param);
-    int numworkers = nprocs - 1;
-    int chunk = n / numworkers;
-    int extra = n % numworkers;
-    int offset, mytype, workLoad, p;
-    int workLoadSize;
-    // to decide the size of the datastructures for each process
-    if (rank == COORDINATOR) {
-        workLoadSize = n;
-    } else {
-        workLoadSize = (rank == numworkers) ? chunk + extra : chunk;
-    }
-
-    MPI_Status status;
-    LDS *lds;
-    std::vector<int> roundThresholds(n, 0);
-    if (rank != COORDINATOR) {
-        roundThresholds.clear();
-    }
-    double remaingingBudget = (factor != 1.0) ? (1.0 - factor) : 0.0;
-
-    if (rank == COORDINATOR) {
-        lds = new LDS(n, phi, delta, levels_per_group, false);
-        GeometricDistribution* geomThreshold = new GeometricDistribution(epsilon * factor);
-        for (int node = 0; node < n; node++) {
-            int noisedDegree = graph->getNodeDegree(node) + geomThreshold->Sample();
-            if (bias == 1) {
-                noisedDegree -= std::min(noisedDegree - 1, bias_factor);
-            }
-            // int numberOfRounds = ceil(log_a_to_base_b(noisedDegree, 1.0 + phi)) * levels_per_group;
-            int numberOfRounds = ceil(log2(noisedDegree)) * levels_per_group;
-            roundThresholds[node] = numberOfRounds;
-        }
-    }
-    MPI_Barrier(MPI_COMM_WORLD);
-    std::vector<int> permanentZeros(workLoadSize, 1);
-
-    for (int r = 0; r < number_of_rounds - 2; r++) {
-        std::chrono::time_point<std::chrono::high_resolution_clock> round_start, round_end;
-	    std::chrono::duration<double> round_elapsed;
-        double round_time = 0.0;
-        // each node either releases 1 or 0 and the coordinator updates the level accordingly
-        // nextLevels stores this information
-        round_start = std::chrono::high_resolution_clock::now();
-        std::vector<int> currentLevels(n);
-        std::vector<int> nextLevels(workLoadSize, 0);
-        int group_index; 
-        if (rank == COORDINATOR) {
-            for (int node = 0; node < n; node++) {
-                currentLevels[node] = lds->get_level(node);
-                if (roundThresholds[node] == r) {
-                    permanentZeros[node] = 0;
-                }
-            }
-            group_index = lds->group_for_level(r);
-
-            offset = 0;
-            mytype = FROM_MASTER;
-            for (p = 1; p <= numworkers; p++) {
-                workLoad = (p == numworkers) ? chunk + extra : chunk;
-                MPI_Send(&offset, 1, MPI_INT, p, mytype, MPI_COMM_WORLD);
-                MPI_Send(&workLoad, 1, MPI_INT, p, mytype, MPI_COMM_WORLD);
-                MPI_Send(&group_index, 1, MPI_INT, p, mytype, MPI_COMM_WORLD);
-                MPI_Send(&currentLevels[0], currentLevels.size(), MPI_INT, p, mytype, MPI_COMM_WORLD);
-                MPI_Send(&permanentZeros[offset], workLoad, MPI_INT, p, mytype, MPI_COMM_WORLD);
-                offset += workLoad;
-            }
-
-            // receive results from workers
-            for (p = 1; p <= numworkers; p++) {
-                mytype = FROM_WORKER + p;
-                MPI_Recv(&offset, 1, MPI_INT, p, mytype, MPI_COMM_WORLD, &status);
-                MPI_Recv(&workLoad, 1, MPI_INT, p, mytype, MPI_COMM_WORLD, &status);
-                MPI_Recv(&nextLevels[offset], workLoad, MPI_INT, p, mytype, MPI_COMM_WORLD, &status);
-                MPI_Recv(&permanentZeros[offset], workLoad, MPI_INT, p, mytype, MPI_COMM_WORLD, &status);
-            }
-
-            // update the levels based on the data in nextLevels
-            for (int i = 0; i < nextLevels.size(); i++) {
-                if (nextLevels[i] == 1 && permanentZeros[i] != 0) {
-                    lds->level_increase_v2(i, lds->L);
-                } 
-            }
-        } else {
-            // worker task
-            mytype = FROM_MASTER;
-            MPI_Recv(&offset, 1, MPI_INT, COORDINATOR, mytype, MPI_COMM_WORLD, &status);
-            MPI_Recv(&workLoad, 1, MPI_INT, COORDINATOR, mytype, MPI_COMM_WORLD, &status);
-            MPI_Recv(&group_index, 1, MPI_INT, COORDINATOR, mytype, MPI_COMM_WORLD, &status);
-            MPI_Recv(&currentLevels[0], currentLevels.size(), MPI_INT, COORDINATOR, mytype, MPI_COMM_WORLD, &status);
-            MPI_Recv(&permanentZeros[0], workLoad, MPI_INT, COORDINATOR, mytype, MPI_COMM_WORLD, &status);
-
-            // perform computation
-            int end_node = offset + workLoad;
-            for (int i = offset; i < end_node; i++) {
-                if (currentLevels[i] == r && permanentZeros[i - offset] != 0) {
-                   int U_i = 0;
-                   for (auto ngh : graph->getNeighbors(i)) {
-                        if (currentLevels[ngh] == r) {
-                            U_i += 1;
-                        }
-                   }
-
-                   double lambda = (epsilon * remaingingBudget) / (2.0 * rounds_param);
-                   GeometricDistribution* geom = new GeometricDistribution(lambda);
-                   int noise = geom->Sample();
-                   int U_hat_i = U_i + noise;
-                   if (U_hat_i > pow((1 + phi), group_index)) {
-                        nextLevels[i - offset] = 1;
-                   } else {
-                        permanentZeros[i - offset] = 0;
-                   }
-                }
-            }
-
-            // send back the completed data to COORDINATOR
-            mytype = FROM_WORKER + rank;
-            MPI_Send(&offset, 1, MPI_INT, COORDINATOR, mytype, MPI_COMM_WORLD);
-            MPI_Send(&workLoad, 1, MPI_INT, COORDINATOR, mytype, MPI_COMM_WORLD);
-            MPI_Send(&nextLevels[0], workLoad, MPI_INT, COORDINATOR, mytype, MPI_COMM_WORLD);
-            MPI_Send(&permanentZeros[0], workLoad, MPI_INT, COORDINATOR, mytype, MPI_COMM_WORLD);
-
-        }
-
-        MPI_Barrier(MPI_COMM_WORLD);
-        round_end = std::chrono::high_resolution_clock::now();
-        round_elapsed = round_end - round_start;
-        round_time = round_elapsed.count();
-       // if (rank == COORDINATOR) {
-         //    std::cout << "Round " << r << " | " << number_of_rounds - 2 << std::endl;
-           //  std::cout << "Round time: " << round_time << std::endl;
-         //}
-    }
-    MPI_Barrier(MPI_COMM_WORLD);
-    // free up memory
-    permanentZeros.clear();
-    // roundThresholds.clear();
-    permanentZeros.shrink_to_fit();
-    // roundThresholds.shrink_to_fit();
-
-    return lds;
-}
-
-// Computing Approximate Core Numbers
-std::vector<double> estimateCoreNumbers(LDS* lds, int n, double eta, double phi, double lambda, double levels_per_group) {
-    std::vector<double> coreNumbers(n);
-    double two_plus_lambda = 2.0 + lambda;
-    double one_plus_phi = 1.0 + phi;
-    for (int i = 0; i < n ; i++) {
-        double frac_numerator = lds->get_level(i) + 1.0;
-        double power = std::max(floor(frac_numerator / levels_per_group) - 1.0, 0.0);
-        coreNumbers[i] = two_plus_lambda * pow(one_plus_phi, power);
-    }
-    return coreNumbers;
-}
-
-
-} // end of namespace distributed_kcore
+#include "KCore.h"
+#include "MultiTrial.h"
+#include "DistributedLDS.h"
+#include "ParallelLoad.h"
+#include "Service.h"
+#include "SyntheticGraphs.h"
 
 int main(int argc, char** argv) {
 
@@ -197,22 +19,27 @@ int main(int argc, char** argv) {
     distributed_kcore::Graph *graph;
 
     int factor_id = std::stoi(argv[5]);
-    double factor;
-    if (factor_id == 0) {
-        factor = 1.0 / 4.0;
-    } else if (factor_id == 1) {
-        factor = 1.0 / 3.0;
-    } else if (factor_id == 2) {
-        factor = 1.0 / 2.0;
-    } else if (factor_id == 3) {
-        factor = 2.0 / 3.0;
-    } else {
-        factor = 3.0 / 4.0;
-    }
+    double factor = distributed_kcore::factorFromId(factor_id);
 
     int bias = std::stoi(argv[6]);
     int bias_factor = std::stoi(argv[7]);
-    int n = std::stoi(argv[8]);
+    long long requested_n = std::stoll(argv[8]);
+    if (requested_n > std::numeric_limits<distributed_kcore::vertex_t>::max()) {
+        std::cerr << "Error: n = " << requested_n << " needs 64-bit vertex ids (rebuild with -DKCORE_64BIT_IDS=ON)" << std::endl;
+        return 1;
+    }
+    distributed_kcore::vertex_t n = requested_n;
+    distributed_kcore::RunOptions opts;
+    if (!distributed_kcore::parseRunOptions(argc, argv, 9, opts)) {
+        return 1;
+    }
+    distributed_kcore::pagePolicy() = opts.hugePages;
+    // these modes index vertices with int throughout
+    bool int_ids_only = opts.stream || opts.serve || opts.trials > 1 || !opts.generate.empty() || opts.reorder != distributed_kcore::REORDER_NONE;
+    if (int_ids_only && requested_n > INT_MAX) {
+        std::cerr << "Error: --stream, --serve, --trials, --generate and --reorder support at most " << INT_MAX << " vertices" << std::endl;
+        return 1;
+    }
     double one_plus_phi = 1.0 + phi;
     double levels_per_group = ceil(distributed_kcore::log_a_to_base_b(n, one_plus_phi));
     double lambda = (2.0 / 9.0) * (2.0 * eta - 5.0);
@@ -224,25 +51,103 @@ int main(int argc, char** argv) {
     MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     int numworkers = numProcesses - 1;
-    int chunk = n / numworkers;
-    int extra = n % numworkers;
+    distributed_kcore::vertex_t chunk = n / numworkers;
+    distributed_kcore::vertex_t extra = n % numworkers;
+    if (rank == COORDINATOR && opts.noise.backend == distributed_kcore::RNG_PHILOX) {
+        // the seed determines all the noise, so record it with the results
+        std::cerr << "Noise RNG: philox, seed " << opts.noise.seed << std::endl;
+    }
+
+    if (opts.stream) {
+        if (numProcesses < 2) {
+            std::cerr << "Error: At least 2 processes are required." << std::endl;
+            MPI_Finalize();
+            return 1;
+        }
+        // the graph is built from the updates, so there is nothing to preprocess
+        if (rank == COORDINATOR) {
+            std::cout << "Preprocessing Time: 0" << std::endl;
+        }
+        distributed_kcore::DistributedLDS dlds(rank, numProcesses, n, phi, 9.0, static_cast<int>(levels_per_group));
+        distributed_kcore::UpdateStream* updates = (rank == COORDINATOR) ? new distributed_kcore::UpdateStream(file_loc) : nullptr;
+        distributed_kcore::StreamStats stats = distributed_kcore::runStream(dlds, rank, [&](std::vector<distributed_kcore::EdgeUpdate>& batch) {
+            return updates->next(batch, opts.batchSize);
+        });
+        std::vector<uintE> levels = dlds.gatherLevels();
+        if (rank == COORDINATOR) {
+            for (int i = 0; i < n; i++) {
+                std::cout << i << " : " << dlds.coreNumber(levels[i]) << std::endl;
+            }
+            distributed_kcore::printStreamStats(stats);
+            std::cout << "Algorithm Time: " << stats.seconds << std::endl;
+        }
+        delete updates;
+        MPI_Finalize();
+        return 0;
+    }
+
+    distributed_kcore::SharedNode* sharedNode = nullptr;
+    if (opts.sharedMemory && numProcesses >= 2) {
+        sharedNode = new distributed_kcore::SharedNode(rank, numProcesses, n);
+    }
 
     std::vector<double> preprocessing_times;
     std::chrono::time_point<std::chrono::high_resolution_clock> pp_start, pp_end;
     std::chrono::duration<double> pp_elapsed;
     double pp_time = 0.0;
-    if (rank  == COORDINATOR) {
+    unsigned long long bytes_before_load = distributed_kcore::processBytesRead();
+    distributed_kcore::SyntheticGraphSpec spec;
+    if (!opts.generate.empty() && numProcesses >= 2) {
+        if (!distributed_kcore::SyntheticGraphSpec::fromName(opts.generate, n, opts.edgeFactor, opts.graphSeed, spec)) {
+            std::cerr << "Unknown generator: " << opts.generate << " (expected rmat, er or ba)" << std::endl;
+            MPI_Finalize();
+            return 1;
+        }
         pp_start = std::chrono::high_resolution_clock::now();
-        graph = new distributed_kcore::Graph(file_loc);
+        graph = distributed_kcore::generateDistributedGraph(spec, rank, numProcesses, opts.generateOut);
+        if (graph == nullptr) {
+            delete sharedNode;
+            MPI_Finalize();
+            return 1;
+        }
+        pp_end = std::chrono::high_resolution_clock::now();
+        pp_elapsed = (pp_end - pp_start);
+        pp_time = pp_elapsed.count();
+        preprocessing_times.push_back(pp_time);
+    } else if (opts.parallelLoad && numProcesses >= 2) {
+        pp_start = std::chrono::high_resolution_clock::now();
+        // as with the file, the coordinator needs the degrees unless the workers sample the thresholds
+        bool coordinator_degrees = !opts.distributedInit || opts.reorder != distributed_kcore::REORDER_NONE;
+        graph = distributed_kcore::loadDistributedGraph(file_loc, n, rank, numProcesses, opts.readers, coordinator_degrees);
+        pp_end = std::chrono::high_resolution_clock::now();
+        pp_elapsed = (pp_end - pp_start);
+        pp_time = pp_elapsed.count();
+        preprocessing_times.push_back(pp_time);
+    } else if (rank  == COORDINATOR) {
+        pp_start = std::chrono::high_resolution_clock::now();
+        if (opts.distributedInit && opts.reorder == distributed_kcore::REORDER_NONE) {
+            // the workers take the degrees from their slices, so the full pass over the file is skipped
+            graph = new distributed_kcore::Graph(0, 0);
+        } else {
+            graph = new distributed_kcore::Graph(file_loc);
+        }
+        if (sharedNode != nullptr) {
+            // the coordinator owns no slice but its node's workers load through it
+            sharedNode->loadGraph(file_loc, 0, 0);
+        }
         pp_end = std::chrono::high_resolution_clock::now();
         pp_elapsed = (pp_end - pp_start);
         pp_time = pp_elapsed.count();
         preprocessing_times.push_back(pp_time);
     } else {
-        int offset = (rank - 1) * chunk; 
-        int workLoad = (rank == numworkers) ? chunk + extra : chunk;
+        distributed_kcore::vertex_t offset = (rank - 1) * chunk;
+        distributed_kcore::vertex_t workLoad = (rank == numworkers) ? chunk + extra : chunk;
         pp_start = std::chrono::high_resolution_clock::now();
-        graph = new distributed_kcore::Graph(file_loc, offset, workLoad);
+        if (sharedNode != nullptr) {
+            graph = sharedNode->loadGraph(file_loc, offset, workLoad);
+        } else {
+            graph = new distributed_kcore::Graph(file_loc, offset, workLoad);
+        }
         pp_end = std::chrono::high_resolution_clock::now();
         pp_elapsed = (pp_end - pp_start);
         pp_time = pp_elapsed.count();
@@ -250,6 +155,38 @@ int main(int argc, char** argv) {
     }
 
     MPI_Barrier(MPI_COMM_WORLD);
+    if (opts.generate.empty() && numProcesses >= 2) {
+        distributed_kcore::reportLoadBytes(distributed_kcore::processBytesRead() - bytes_before_load, file_loc, rank, COORDINATOR);
+    }
+    std::vector<int> perm;
+    if (opts.reorder != distributed_kcore::REORDER_NONE && numProcesses >= 2) {
+        pp_start = std::chrono::high_resolution_clock::now();
+        perm = distributed_kcore::relabelGraph(graph, opts.reorder, rank, numProcesses, n);
+        pp_end = std::chrono::high_resolution_clock::now();
+        pp_elapsed = (pp_end - pp_start);
+        if (rank == COORDINATOR) {
+            std::cerr << "Reorder Time: " << pp_elapsed.count() << std::endl;
+        }
+    }
+    // with --sparsify-compare the full graph is run first, its cores kept for the report
+    std::vector<double> full_core_numbers;
+    double full_algo_time = 0.0;
+    if (opts.sparsify.kind != distributed_kcore::SPARSIFY_NONE && numProcesses >= 2) {
+        if (opts.sparsifyCompare) {
+            std::chrono::time_point<std::chrono::high_resolution_clock> full_start = std::chrono::high_resolution_clock::now();
+            distributed_kcore::LDS* full_lds = distributed_kcore::KCore_compute(rank, numProcesses, graph, eta, epsilon, phi, lambda, static_cast<int>(levels_per_group), factor, bias, bias_factor, n, opts, sharedNode);
+            if (rank == COORDINATOR) {
+                full_core_numbers = distributed_kcore::estimateCoreNumbers(full_lds, n, eta, phi, lambda, levels_per_group);
+                delete full_lds;
+            }
+            std::chrono::duration<double> full_elapsed = std::chrono::high_resolution_clock::now() - full_start;
+            full_algo_time = full_elapsed.count();
+        }
+        distributed_kcore::sparsifyWorkerSlices(graph, opts.sparsify, opts.graphSeed, rank, COORDINATOR);
+    }
+    if (opts.compress && numProcesses >= 2) {
+        distributed_kcore::compressWorkerSlices(graph, rank, COORDINATOR);
+    }
     double max_pp_time = *std::max_element(preprocessing_times.begin(), preprocessing_times.end());
     
 
@@ -259,25 +196,84 @@ int main(int argc, char** argv) {
         return 1;
     }
      
-    if (rank == COORDINATOR) {
+    if (opts.serve) {
+        distributed_kcore::serveJobs(rank, COORDINATOR, n, opts.serveSocket, max_pp_time, [&](const distributed_kcore::ServiceJob& job) {
+            double job_levels_per_group = ceil(distributed_kcore::log_a_to_base_b(n, 1.0 + job.phi));
+            distributed_kcore::LDS* lds = distributed_kcore::KCore_compute(rank, numProcesses, graph, eta, job.epsilon, job.phi, lambda,
+                static_cast<int>(job_levels_per_group), distributed_kcore::factorFromId(job.factorId), job.bias, job.biasFactor, n, opts, sharedNode);
+            std::vector<double> cores;
+            if (rank == COORDINATOR) {
+                std::vector<double> estimated_core_numbers = distributed_kcore::estimateCoreNumbers(lds, n, eta, job.phi, lambda, job_levels_per_group);
+                delete lds;
+                cores.resize(n);
+                for (int i = 0; i < n; i++) {
+                    cores[i] = estimated_core_numbers[perm.empty() ? i : perm[i]];
+                }
+            }
+            return cores;
+        });
+    } else if (opts.trials > 1) {
+        std::vector<distributed_kcore::TrialLane> lanes = distributed_kcore::makeTrialLanes(opts, factor_id, bias_factor);
+        if (rank == COORDINATOR) {
+            std::cout << "Preprocessing Time: " << max_pp_time << std::endl;
+        }
+        std::chrono::time_point<std::chrono::high_resolution_clock> algo_start = std::chrono::high_resolution_clock::now();
+        std::vector<uint16_t> levels = distributed_kcore::KCore_compute_trials(rank, numProcesses, graph, epsilon, phi, static_cast<int>(levels_per_group), lanes, bias, n, opts);
+        if (rank == COORDINATOR) {
+            int trials = lanes.size();
+            int stride = distributed_kcore::laneStride(trials);
+            std::vector<double> cores(static_cast<size_t>(n) * trials);
+            for (int v = 0; v < n; v++) {
+                for (int t = 0; t < trials; t++) {
+                    cores[static_cast<size_t>(v) * trials + t] = distributed_kcore::coreNumberForLevel(levels[static_cast<size_t>(v) * stride + t], phi, lambda, levels_per_group);
+                }
+            }
+            std::chrono::duration<double> algo_elapsed = std::chrono::high_resolution_clock::now() - algo_start;
+            // stdout keeps the single-run format with the mean over the trials
+            for (int i = 0; i < n; i++) {
+                size_t id = perm.empty() ? i : perm[i];
+                double sum = 0.0;
+                for (int t = 0; t < trials; t++) {
+                    sum += cores[id * trials + t];
+                }
+                std::cout << i << " : " << sum / trials << std::endl;
+            }
+            if (!opts.trialsOut.empty() && distributed_kcore::writeTrialEstimates(opts.trialsOut, cores, n, lanes, perm)) {
+                std::cerr << "Trial estimates written to " << opts.trialsOut << std::endl;
+            }
+            std::cout << "Algorithm Time: " << algo_elapsed.count() << std::endl;
+        }
+    } else if (rank == COORDINATOR) {
         // graph->printDegrees();
         std::cout << "Preprocessing Time: " << max_pp_time << std::endl;
         std::chrono::time_point<std::chrono::high_resolution_clock> algo_start, algo_end;
 	    std::chrono::duration<double> algo_elapsed;
         double algo_time = 0.0;
         algo_start = std::chrono::high_resolution_clock::now();
-        distributed_kcore::LDS* lds = distributed_kcore::KCore_compute(rank, numProcesses, graph, eta, epsilon, phi, lambda, static_cast<int>(levels_per_group), factor, bias, bias_factor, n);
+        distributed_kcore::LDS* lds = distributed_kcore::KCore_compute(rank, numProcesses, graph, eta, epsilon, phi, lambda, static_cast<int>(levels_per_group), factor, bias, bias_factor, n, opts, sharedNode);
         std::vector<double> estimated_core_numbers = distributed_kcore::estimateCoreNumbers(lds, n, eta, phi, lambda, levels_per_group);
         algo_end = std::chrono::high_resolution_clock::now();
         algo_elapsed = algo_end - algo_start;
         // std::cout << "Printing Core Numbers" << std::endl;
-        for (int i = 0; i < n; i++) {
-            std::cout<< i << " : " << estimated_core_numbers[i] << std::endl;
+        for (distributed_kcore::vertex_t i = 0; i < n; i++) {
+            // report under the original vertex ids
+            distributed_kcore::vertex_t id = perm.empty() ? i : perm[i];
+            std::cout<< i << " : " << estimated_core_numbers[id] << std::endl;
         }
         algo_time = algo_elapsed.count();
+        if (opts.sparsifyCompare) {
+            distributed_kcore::reportSparsifiedCores(full_core_numbers, estimated_core_numbers, full_algo_time, algo_time);
+        }
         std::cout << "Algorithm Time: " << algo_time << std::endl;
     } else {
-        distributed_kcore::LDS* lds = distributed_kcore::KCore_compute(rank, numProcesses, graph, eta, epsilon, phi, lambda, static_cast<int>(levels_per_group), factor, bias, bias_factor, n);
+        distributed_kcore::LDS* lds = distributed_kcore::KCore_compute(rank, numProcesses, graph, eta, epsilon, phi, lambda, static_cast<int>(levels_per_group), factor, bias, bias_factor, n, opts, sharedNode);
+    }
+    if (sharedNode != nullptr) {
+        sharedNode->report(COORDINATOR);
+        delete sharedNode;
+    }
+    if (opts.reportHugePages) {
+        distributed_kcore::reportPages(rank, COORDINATOR);
     }
     
     MPI_Finalize();
@@ -0,0 +1,505 @@
+/**
+ * @file KCore.h
+ * @brief Approximate KCore Distributed Algorithm
+*/
+
+#pragma once
+
+#include <math.h>
+#include <mpi.h>
+#include <vector>
+#include <string>
+#include <set>
+#include <unordered_map>
+#include <chrono>
+#include <thread>
+#include "LDS.h"
+#include "Graph.h"
+#include "distributions.h"
+#include "CounterRng.h"
+#include "Options.h"
+#include "Checkpoint.h"
+#include "Metrics.h"
+#include "PerfCounters.h"
+#include "Rebalance.h"
+#include "SameLevelCounts.h"
+#include "SharedMemory.h"
+#include "RoundEngine.h"
+#include "AllocCounter.h"
+
+#define COORDINATOR 0 
+#define FROM_MASTER 1
+#define FROM_WORKER 2
+
+namespace distributed_kcore {
+
+
+inline int log_a_to_base_b(int64_t a, double b) {
+    // log_b a = log_2 a / log_2 b
+    return log2(a) / log2(b);
+}
+
+// Share of epsilon spent on the degree thresholds for the factor_id argument.
+inline double factorFromId(int factor_id) {
+    if (factor_id == 0) {
+        return 1.0 / 4.0;
+    } else if (factor_id == 1) {
+        return 1.0 / 3.0;
+    } else if (factor_id == 2) {
+        return 1.0 / 2.0;
+    } else if (factor_id == 3) {
+        return 2.0 / 3.0;
+    }
+    return 3.0 / 4.0;
+}
+
+/**
+ * Worker side of round r over the slice [offset, offset + workLoad): every vertex
+ * still at level r counts its neighbours at level r, adds geometric noise and
+ * either moves up (nextLevels = 1) or becomes a permanent zero. With sameLevel
+ * the counts are maintained incrementally instead of rescanning the adjacency.
+ * currentLevels is anything indexable by vertex (a vector or a LevelView).
+ * The noise of vertex i comes from noise's (NOISE_ROUND, r, i) stream. On a
+ * sparsified graph the count is scaled up to the full degree first.
+*/
+template <class G, class V, class Levels>
+inline void workerRound(G* graph, int r, int group_index, V offset, V workLoad, const Levels& currentLevels,
+        std::vector<int>& permanentZeros, std::vector<int>& nextLevels, double lambda, double phi, [[maybe_unused]] MetricsRecorder& metrics,
+        SameLevelCounts* sameLevel = nullptr, const NoiseSource& noiseSource = NoiseSource()) {
+    KCORE_TIMER_START(compute_start);
+    if (sameLevel != nullptr) {
+        [[maybe_unused]] uint64_t scanned = sameLevel->getEdgesScanned();
+        sameLevel->advance(r, currentLevels);
+        KCORE_COUNT(metrics, COUNT_EDGES_SCANNED, sameLevel->getEdgesScanned() - scanned);
+    }
+    GeometricDistribution geom(lambda);
+    V end_node = offset + workLoad;
+    for (V i = offset; i < end_node; i++) {
+        if (currentLevels[i] == r && permanentZeros[i - offset] != 0) {
+           int U_i = 0;
+           if (sameLevel != nullptr) {
+                U_i = sameLevel->get(i);
+                sameLevel->addRescanEdges(graph->getNeighborCount(i));
+           } else {
+                auto neighbors = graph->getNeighbors(i);
+                for (auto ngh : neighbors) {
+                    if (currentLevels[ngh] == r) {
+                        U_i += 1;
+                    }
+                }
+                KCORE_COUNT(metrics, COUNT_EDGES_SCANNED, neighbors.size());
+           }
+           if (graph->isSparsified()) {
+                U_i = static_cast<int>(std::lround(U_i * graph->getNeighborScale(i)));
+           }
+           KCORE_COUNT(metrics, COUNT_ACTIVE_VERTICES, 1);
+
+           KCORE_TIMER_START(noise_start);
+           int noise = noiseSource.sample(geom, NOISE_ROUND, r, i);
+           KCORE_TIMER_STOP(metrics, PHASE_NOISE, noise_start);
+           int U_hat_i = U_i + noise;
+           if (U_hat_i > pow((1 + phi), group_index)) {
+                nextLevels[i - offset] = 1;
+           } else {
+                permanentZeros[i - offset] = 0;
+           }
+        }
+    }
+    KCORE_TIMER_STOP(metrics, PHASE_COMPUTE, compute_start);
+    KCORE_TIMER_EXCLUDE(metrics, PHASE_COMPUTE, PHASE_NOISE);
+}
+
+/**
+ * Fills thresholds[i] with the round at which vertex offset + i stops rising:
+ * its degree(offset + i) plus Geometric(epsilon * factor) noise (less
+ * bias_factor when bias == 1), in levels. The range is split evenly over
+ * threads; degree must be safe to call concurrently when threads > 1.
+*/
+template <class V, class Degree>
+void sampleRoundThresholds(std::vector<int>& thresholds, V offset, V count, const Degree& degree, double epsilon, double factor,
+        int bias, int bias_factor, int levels_per_group, int threads, const NoiseSource& noiseSource = NoiseSource()) {
+    auto sampleRange = [&](V begin, V end) {
+        GeometricDistribution geomThreshold(epsilon * factor);
+        for (V i = begin; i < end; i++) {
+            int64_t noisedDegree = static_cast<int64_t>(degree(offset + i)) + noiseSource.sample(geomThreshold, NOISE_THRESHOLD, 0, offset + i);
+            if (bias == 1) {
+                noisedDegree -= std::min<int64_t>(noisedDegree - 1, bias_factor);
+            }
+            // int numberOfRounds = ceil(log_a_to_base_b(noisedDegree, 1.0 + phi)) * levels_per_group;
+            int numberOfRounds = ceil(log2(noisedDegree)) * levels_per_group;
+            thresholds[i] = numberOfRounds;
+        }
+    };
+    if (threads <= 1) {
+        sampleRange(0, count);
+        return;
+    }
+    std::vector<std::thread> pool;
+    V step = (count + threads - 1) / threads;
+    for (int t = 0; t < threads; t++) {
+        V begin = std::min<V>(count, t * step);
+        pool.emplace_back(sampleRange, begin, std::min<V>(count, begin + step));
+    }
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+}
+
+/**
+ * V and E are the graph's vertex and edge types. Vertex ranges use V; the
+ * level, permanentZeros and nextLevels arrays move in kMpiChunk pieces so n
+ * may exceed the int count of a single MPI call.
+*/
+template <class V, class E>
+LDST<V>* KCore_compute(int rank, int nprocs, GraphT<V, E>* graph, double eta, double epsilon, double phi, double lambda, int levels_per_group, double factor, int bias, int bias_factor, V n, const RunOptions& opts,
+        SharedNode* sharedNode = nullptr) {
+    double delta = 9.0;
+    double rounds_param = ceil(4.0 * pow(log_a_to_base_b(n, 1.0 + phi), 1.5));
+    int number_of_rounds = static_cast<int>(rounds_param);
+    int numworkers = nprocs - 1;
+    V chunk = n / numworkers;
+    V extra = n % numworkers;
+    V offset, workLoad;
+    int p;
+    V workLoadSize;
+    // worker p owns [bounds[p - 1], bounds[p]); with --rebalance the slices the graph holds now,
+    // which an earlier job of --serve may have moved
+    std::vector<V> bounds(nprocs, 0);
+    for (p = 1; p <= numworkers; p++) {
+        bounds[p] = (p == numworkers) ? p * chunk + extra : p * chunk;
+    }
+    LoadBalancer<V>* balancer = nullptr;
+    if (opts.rebalance) {
+        balancer = new LoadBalancer<V>(rank, nprocs, graph->getSliceOffset(), graph->getSliceSize(), opts.rebalanceThreshold);
+        bounds = balancer->getBounds();
+    }
+    // to decide the size of the datastructures for each process
+    if (rank == COORDINATOR) {
+        workLoadSize = n;
+    } else {
+        workLoadSize = bounds[rank] - bounds[rank - 1];
+    }
+
+    LDST<V>* lds = nullptr;
+    // the thresholds live on the coordinator, or with --distributed-init on the owner of each slice
+    std::vector<int> roundThresholds;
+    if (opts.distributedInit) {
+        roundThresholds.resize(rank != COORDINATOR ? workLoadSize : 0, 0);
+    } else if (rank == COORDINATOR) {
+        roundThresholds.resize(n, 0);
+    }
+    double remaingingBudget = (factor != 1.0) ? (1.0 - factor) : 0.0;
+    std::vector<int> permanentZeros(workLoadSize, 1);
+
+    Checkpointer* checkpointer = nullptr;
+    int startRound = 0;
+    if (!opts.checkpointDir.empty()) {
+        CheckpointSettings settings;
+        settings.epsilon = epsilon;
+        settings.phi = phi;
+        settings.factor = factor;
+        settings.bias = bias;
+        settings.biasFactor = bias_factor;
+        settings.levelsPerGroup = levels_per_group;
+        settings.rngBackend = opts.noise.backend;
+        settings.rngSeed = opts.noise.seed;
+        unsigned long long entries = (rank != COORDINATOR) ? graph->sumAdjList() : 0, totalEntries = 0;
+        MPI_Allreduce(&entries, &totalEntries, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+        settings.graphEntries = totalEntries;
+        checkpointer = new Checkpointer(opts.checkpointDir, opts.checkpointEvery, rank, nprocs, n, settings);
+        if (opts.resume) {
+            startRound = checkpointer->latestConsistentRound() + 1;
+        }
+    }
+
+    if (rank == COORDINATOR) {
+        lds = new LDST<V>(n, phi, delta, levels_per_group, false);
+    }
+    if (startRound > 0) {
+        // the thresholds are noisy, so they are restored rather than resampled
+        if (rank == COORDINATOR && !checkpointer->load(startRound - 1, lds, permanentZeros, roundThresholds)) {
+            std::cerr << "Failed to restore checkpoint of round " << startRound - 1 << ", starting over" << std::endl;
+            startRound = 0;
+            lds->L = decltype(lds->L)(n);
+            std::fill(permanentZeros.begin(), permanentZeros.end(), 1);
+        }
+        MPI_Bcast(&startRound, 1, MPI_INT, COORDINATOR, MPI_COMM_WORLD);
+        if (rank == COORDINATOR && startRound > 0) {
+            std::cerr << "Resuming from round " << startRound << std::endl;
+        }
+    }
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> init_start = std::chrono::high_resolution_clock::now();
+    if (startRound == 0) {
+        if (opts.distributedInit && rank != COORDINATOR) {
+            // degrees straight from the local adjacency, nothing is sent to the coordinator
+            sampleRoundThresholds(roundThresholds, bounds[rank - 1], workLoadSize, [&](V node) { return graph->getFullNeighborCount(node); },
+                epsilon, factor, bias, bias_factor, levels_per_group, opts.initThreads, opts.noise);
+        } else if (!opts.distributedInit && rank == COORDINATOR) {
+            sampleRoundThresholds(roundThresholds, static_cast<V>(0), n, [&](V node) { return graph->getNodeDegree(node); },
+                epsilon, factor, bias, bias_factor, levels_per_group, 1, opts.noise);
+        }
+    }
+    std::chrono::duration<double> init_elapsed = std::chrono::high_resolution_clock::now() - init_start;
+    double local_init_time = init_elapsed.count(), max_init_time = 0.0;
+    MPI_Reduce(&local_init_time, &max_init_time, 1, MPI_DOUBLE, MPI_MAX, COORDINATOR, MPI_COMM_WORLD);
+    if (rank == COORDINATOR && startRound == 0) {
+        std::cerr << "Init Time: " << max_init_time << (opts.distributedInit ? " (distributed)" : " (coordinator)") << std::endl;
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    MetricsRecorder metrics;
+    metrics.reserve(std::max(number_of_rounds - 2 - startRound, 0));
+    PerfCounters* perf = (opts.perfCounters && rank != COORDINATOR) ? new PerfCounters() : nullptr;
+    SameLevelCounts* sameLevel = (opts.incremental && rank != COORDINATOR) ? new SameLevelCounts(graph) : nullptr;
+    double total_round_time = 0.0;
+    // same-level counts of the slices a worker held before a rebalance
+    unsigned long long movedEdgesScanned = 0, movedRescanEdges = 0;
+    // round buffers are allocated once: the coordinator's nextLevels backs the RMA window,
+    // and with a SharedNode the levels live in the node's shared window instead
+    std::vector<int, PageAllocator<int>> currentLevels(sharedNode != nullptr ? 0 : n);
+    int* levels = (sharedNode != nullptr) ? sharedNode->getLevels() : currentLevels.data();
+    std::vector<int> nextLevels(workLoadSize, 0);
+    int group_index = 0;
+    RmaResults* rma = (opts.transport == TRANSPORT_RMA) ? new RmaResults(rank, COORDINATOR, nextLevels, permanentZeros) : nullptr;
+    RoundEngine* engine = new RoundEngine(rank, numworkers, COORDINATOR, FROM_MASTER, FROM_WORKER, bounds, levels, &group_index,
+                                          permanentZeros, nextLevels, sharedNode, rma == nullptr);
+    int levelMessages = 0;
+    for (p = 1; p <= numworkers; p++) {
+        levelMessages += (sharedNode == nullptr || sharedNode->receivesLevels(p)) ? 1 : 0;
+    }
+    offset = (rank == COORDINATOR) ? 0 : bounds[rank - 1];
+    workLoad = workLoadSize;
+    double lambda_round = (epsilon * remaingingBudget) / (2.0 * rounds_param);
+    unsigned long long steady_allocations = 0;
+    for (int r = startRound; r < number_of_rounds - 2; r++) {
+        unsigned long long allocations_before = heapAllocations();
+        KCORE_METRICS_ROUND(metrics, r);
+        std::chrono::time_point<std::chrono::high_resolution_clock> round_start, round_end;
+	    std::chrono::duration<double> round_elapsed;
+        double round_time = 0.0;
+        double compute_time = 0.0;
+        // each node either releases 1 or 0 and the coordinator updates the level accordingly
+        // nextLevels stores this information
+        round_start = std::chrono::high_resolution_clock::now();
+        std::fill(nextLevels.begin(), nextLevels.end(), 0);
+        if (rank == COORDINATOR) {
+            for (V node = 0; node < n; node++) {
+                levels[node] = lds->get_level(node);
+                if (!opts.distributedInit && roundThresholds[node] == r) {
+                    permanentZeros[node] = 0;
+                }
+            }
+            group_index = lds->group_for_level(r);
+
+            KCORE_TIMER_START(send_start);
+            engine->send();
+            if (sharedNode != nullptr) {
+                sharedNode->sync();
+            }
+            KCORE_TIMER_STOP(metrics, PHASE_SEND, send_start);
+            KCORE_COUNT(metrics, COUNT_BYTES_SENT, sizeof(int) * (numworkers + levelMessages * static_cast<double>(n) + n));
+
+            // receive results from workers
+            KCORE_TIMER_START(recv_start);
+            if (rma != nullptr) {
+                rma->collect();
+            } else {
+                engine->receive();
+            }
+            KCORE_TIMER_STOP(metrics, PHASE_RECV, recv_start);
+            KCORE_COUNT(metrics, COUNT_BYTES_RECEIVED, sizeof(int) * 2.0 * n);
+
+            // update the levels based on the data in nextLevels
+            KCORE_TIMER_START(apply_start);
+            for (V i = 0; i < n; i++) {
+                if (nextLevels[i] == 1 && permanentZeros[i] != 0) {
+                    lds->level_increase_v2(i, lds->L);
+                } 
+            }
+            KCORE_TIMER_STOP(metrics, PHASE_APPLY, apply_start);
+        } else {
+            // worker task
+            KCORE_TIMER_START(recv_start);
+            engine->receive();
+            [[maybe_unused]] bool receivesLevels = (sharedNode == nullptr || sharedNode->receivesLevels(rank));
+            if (opts.distributedInit) {
+                for (V i = 0; i < workLoad; i++) {
+                    if (roundThresholds[i] == r) {
+                        permanentZeros[i] = 0;
+                    }
+                }
+            }
+            if (sharedNode != nullptr) {
+                sharedNode->sync();
+            }
+            KCORE_TIMER_STOP(metrics, PHASE_RECV, recv_start);
+            KCORE_COUNT(metrics, COUNT_BYTES_RECEIVED, sizeof(int) * (1.0 + (receivesLevels ? n : 0) + workLoad));
+
+            // perform computation
+            if (perf != nullptr) {
+                perf->start();
+            }
+            std::chrono::time_point<std::chrono::high_resolution_clock> compute_start = std::chrono::high_resolution_clock::now();
+            workerRound(graph, r, group_index, offset, workLoad, LevelView{levels}, permanentZeros, nextLevels, lambda_round, phi, metrics, sameLevel, opts.noise);
+            std::chrono::duration<double> compute_elapsed = std::chrono::high_resolution_clock::now() - compute_start;
+            compute_time = compute_elapsed.count();
+            if (perf != nullptr) {
+                perf->stop();
+            }
+
+            // send back the completed data to COORDINATOR
+            KCORE_TIMER_START(send_start);
+            if (rma != nullptr) {
+                rma->put(COORDINATOR, nextLevels, permanentZeros, offset, workLoad);
+            } else {
+                engine->send();
+            }
+            KCORE_TIMER_STOP(metrics, PHASE_SEND, send_start);
+            KCORE_COUNT(metrics, COUNT_BYTES_SENT, sizeof(int) * 2.0 * workLoad);
+        }
+
+        KCORE_TIMER_START(barrier_start);
+        MPI_Barrier(MPI_COMM_WORLD);
+        KCORE_TIMER_STOP(metrics, PHASE_BARRIER, barrier_start);
+        round_end = std::chrono::high_resolution_clock::now();
+        round_elapsed = round_end - round_start;
+        round_time = round_elapsed.count();
+        total_round_time += round_time;
+        // the first round may still touch lazily allocated state; later ones must not allocate
+        if (r > startRound) {
+            steady_allocations += heapAllocations() - allocations_before;
+        }
+        if (checkpointer != nullptr) {
+            checkpointer->addRoundTime(round_time);
+            if (checkpointer->due(r)) {
+                checkpointer->write(r, (rank == COORDINATOR) ? lds : nullptr, permanentZeros, roundThresholds);
+            }
+        }
+        // outside the allocation window: a move reallocates the slice and the round buffers
+        if (balancer != nullptr) {
+            if (rank != COORDINATOR) {
+                balancer->measure(graph, compute_time, levels, r, nextLevels, permanentZeros);
+            }
+            if (balancer->step(number_of_rounds - 3 - r)) {
+                balancer->migrate(graph, opts.distributedInit ? &roundThresholds : nullptr);
+                bounds = balancer->getBounds();
+                delete engine;
+                if (rank != COORDINATOR) {
+                    offset = bounds[rank - 1];
+                    workLoad = bounds[rank] - bounds[rank - 1];
+                    permanentZeros.assign(workLoad, 1);
+                    nextLevels.assign(workLoad, 0);
+                    if (sameLevel != nullptr) {
+                        movedEdgesScanned += sameLevel->getEdgesScanned();
+                        movedRescanEdges += sameLevel->getRescanEdges();
+                        delete sameLevel;
+                        sameLevel = new SameLevelCounts(graph);
+                    }
+                }
+                engine = new RoundEngine(rank, numworkers, COORDINATOR, FROM_MASTER, FROM_WORKER, bounds, levels, &group_index,
+                                         permanentZeros, nextLevels, sharedNode, rma == nullptr);
+            }
+        }
+       // if (rank == COORDINATOR) {
+         //    std::cout << "Round " << r << " | " << number_of_rounds - 2 << std::endl;
+           //  std::cout << "Round time: " << round_time << std::endl;
+         //}
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    delete engine;
+    delete rma;
+    if (balancer != nullptr) {
+        balancer->report(total_round_time);
+        delete balancer;
+    }
+#ifdef KCORE_ALLOC_CHECK
+    unsigned long long max_steady_allocations = 0;
+    MPI_Reduce(&steady_allocations, &max_steady_allocations, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX, COORDINATOR, MPI_COMM_WORLD);
+    if (rank == COORDINATOR) {
+        std::cerr << "Steady-State Allocations: " << max_steady_allocations << " (most on one rank)" << std::endl;
+    }
+    assert(steady_allocations == 0);
+#endif
+    if (checkpointer != nullptr) {
+        double local_ckpt_time = checkpointer->getWriteTime();
+        double max_ckpt_time = 0.0;
+        MPI_Reduce(&local_ckpt_time, &max_ckpt_time, 1, MPI_DOUBLE, MPI_MAX, COORDINATOR, MPI_COMM_WORLD);
+        if (rank == COORDINATOR) {
+            double overhead = (total_round_time > 0.0) ? 100.0 * max_ckpt_time / total_round_time : 0.0;
+            std::cerr << "Checkpoints Written: " << checkpointer->checkpointsWritten() << std::endl;
+            std::cerr << "Checkpoint Time: " << max_ckpt_time << " (" << overhead << "% of round time)" << std::endl;
+        }
+        delete checkpointer;
+    }
+    if (opts.perfCounters) {
+        // summed over the workers' compute phase
+        for (int e = 0; e < NUM_PERF_EVENTS; e++) {
+            unsigned long long local = (perf != nullptr) ? perf->total(static_cast<PerfEvent>(e)) : 0;
+            int localAvailable = (perf == nullptr || perf->available(static_cast<PerfEvent>(e))) ? 1 : 0;
+            unsigned long long sum = 0;
+            int available = 0;
+            MPI_Reduce(&local, &sum, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, COORDINATOR, MPI_COMM_WORLD);
+            MPI_Reduce(&localAvailable, &available, 1, MPI_INT, MPI_MIN, COORDINATOR, MPI_COMM_WORLD);
+            if (rank == COORDINATOR) {
+                if (available) {
+                    std::cerr << "Worker " << kPerfEventNames[e] << ": " << sum << std::endl;
+                } else {
+                    std::cerr << "Worker " << kPerfEventNames[e] << ": unavailable" << std::endl;
+                }
+            }
+        }
+        if (rank == COORDINATOR) {
+            int rounds_run = std::max(number_of_rounds - 2 - startRound, 1);
+            std::cerr << "Total Round Time: " << total_round_time << " (" << total_round_time / rounds_run << " per round)" << std::endl;
+        }
+        delete perf;
+    }
+    if (opts.incremental) {
+        unsigned long long local[2] = {movedEdgesScanned, movedRescanEdges}, sum[2] = {0, 0};
+        if (sameLevel != nullptr) {
+            local[0] += sameLevel->getEdgesScanned();
+            local[1] += sameLevel->getRescanEdges();
+        }
+        MPI_Reduce(local, sum, 2, MPI_UNSIGNED_LONG_LONG, MPI_SUM, COORDINATOR, MPI_COMM_WORLD);
+        if (rank == COORDINATOR) {
+            std::cerr << "Edges Scanned: " << sum[0] << " (full rescan: " << sum[1] << ")" << std::endl;
+        }
+        delete sameLevel;
+    }
+    if (!opts.metricsPath.empty()) {
+#ifdef KCORE_METRICS
+        metrics.report(opts.metricsPath, rank, nprocs, COORDINATOR);
+#else
+        if (rank == COORDINATOR) {
+            std::cerr << "--metrics ignored: rebuild with -DKCORE_METRICS=ON" << std::endl;
+        }
+#endif
+    }
+    // free up memory
+    permanentZeros.clear();
+    // roundThresholds.clear();
+    permanentZeros.shrink_to_fit();
+    // roundThresholds.shrink_to_fit();
+
+    return lds;
+}
+
+inline double coreNumberForLevel(int level, double phi, double lambda, double levels_per_group) {
+    double frac_numerator = level + 1.0;
+    double power = std::max(floor(frac_numerator / levels_per_group) - 1.0, 0.0);
+    return (2.0 + lambda) * pow(1.0 + phi, power);
+}
+
+// Computing Approximate Core Numbers
+template <class V>
+std::vector<double> estimateCoreNumbers(LDST<V>* lds, V n, double eta, double phi, double lambda, double levels_per_group) {
+    std::vector<double> coreNumbers(n);
+    for (V i = 0; i < n ; i++) {
+        coreNumbers[i] = coreNumberForLevel(lds->get_level(i), phi, lambda, levels_per_group);
+    }
+    return coreNumbers;
+}
+
+
+} // end of namespace distributed_kcore
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <stack>
 #include <unordered_set>
 #include <vector>
@@ -6,6 +8,8 @@
 #include <iostream>
 #include <cassert>
 #include <math.h>
+#include "HugePages.h"
+#include "IdTypes.h"
 
 typedef int intE;
 typedef unsigned int uintE;
@@ -23,7 +27,9 @@ inline double upper_constant(double delta, bool optimized) {
     }
 }
 
-struct LDS {
+// V is the vertex ID type; levels stay uintE.
+template <class V>
+struct LDST {
     size_t n; // number of vertices
     double delta = 9.0;
     double phi = 3.0;
@@ -35,15 +41,15 @@ struct LDS {
     };
 
     size_t levels_per_group; // number of inner-levels per group. O(\log n) many
-    std::vector<LDSVertex> L;
+    std::vector<LDSVertex, PageAllocator<LDSVertex>> L;
 
-    LDS(size_t _n, double _eps, double _delta, int _levels_per_group, bool _optimized) : n(_n), phi(_eps),
+    LDST(size_t _n, double _eps, double _delta, int _levels_per_group, bool _optimized) : n(_n), phi(_eps),
         delta(_delta), levels_per_group(_levels_per_group), optimized_insertion(_optimized) {
             // levels_per_group = ceil(log(n) / log(1 + phi));
-            L = std::vector<LDSVertex>(n);
+            L = std::vector<LDSVertex, PageAllocator<LDSVertex>>(n);
     }
 
-    uintE get_level(uintE ngh) {
+    uintE get_level(V ngh) {
         return L[ngh].level;
     }
     // Moving u from level to level + 1.
@@ -52,7 +58,7 @@ struct LDS {
      * L -> array to access LDS array easily 
     */
     template <class Levels>
-    void level_increase_v2(uintE u, Levels& L) {
+    void level_increase_v2(V u, Levels& L) {
         L[u].level++;
     }
 
@@ -60,4 +66,6 @@ struct LDS {
         return floor(level / levels_per_group);
     }
 };
+
+typedef LDST<vertex_t> LDS;
 } // end of namespace distributed_kcore
\ No newline at end of file
@@ -0,0 +1,175 @@
+/**
+ * @file Metrics.h
+ * @brief Per-rank, per-round instrumentation of the KCore round loop
+ *
+ * Only compiled in when KCORE_METRICS is defined (cmake -DKCORE_METRICS=ON);
+ * otherwise every KCORE_* macro below expands to nothing.
+*/
+
+#pragma once
+
+#include <mpi.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace distributed_kcore {
+
+enum MetricsPhase {
+    PHASE_SEND = 0,
+    PHASE_RECV,
+    PHASE_COMPUTE,
+    PHASE_NOISE,
+    PHASE_APPLY,
+    PHASE_BARRIER,
+    NUM_PHASES
+};
+
+enum MetricsCounter {
+    COUNT_ACTIVE_VERTICES = 0,
+    COUNT_EDGES_SCANNED,
+    COUNT_BYTES_SENT,
+    COUNT_BYTES_RECEIVED,
+    NUM_COUNTERS
+};
+
+static const char* const kPhaseNames[NUM_PHASES] = {"send", "recv", "compute", "noise", "apply", "barrier"};
+static const char* const kCounterNames[NUM_COUNTERS] = {"active_vertices", "edges_scanned", "bytes_sent", "bytes_received"};
+
+struct RoundMetrics {
+    double seconds[NUM_PHASES] = {0.0};
+    double counts[NUM_COUNTERS] = {0.0};
+};
+
+class MetricsRecorder {
+    private:
+        std::vector<RoundMetrics> rounds;
+        std::vector<int> roundIds;
+
+        static bool endsWith(const std::string& s, const std::string& suffix) {
+            return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+        }
+
+    public:
+        static constexpr int kFields = NUM_PHASES + NUM_COUNTERS;
+
+        // Sizes the per-round storage up front so that recording rounds does not allocate.
+        void reserve(size_t count) {
+            rounds.reserve(count);
+            roundIds.reserve(count);
+        }
+
+        void beginRound(int round) {
+            rounds.emplace_back();
+            roundIds.push_back(round);
+        }
+
+        void addTime(MetricsPhase phase, std::chrono::high_resolution_clock::time_point start) {
+            std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+            rounds.back().seconds[phase] += elapsed.count();
+        }
+
+        void subtractTime(MetricsPhase from, MetricsPhase phase) {
+            rounds.back().seconds[from] -= rounds.back().seconds[phase];
+        }
+
+        void addCount(MetricsCounter counter, double value) {
+            rounds.back().counts[counter] += value;
+        }
+
+        /**
+         * Collective. Gathers every rank's rounds on the coordinator, writes them
+         * to `path` (JSON if it ends in .json, CSV otherwise) and prints, for each
+         * phase, the total of the slowest rank and the rank it was.
+        */
+        void report(const std::string& path, int rank, int nprocs, int coordinator) {
+            int numRounds = rounds.size();
+            std::vector<double> local;
+            local.reserve(numRounds * (kFields + 1));
+            for (int i = 0; i < numRounds; i++) {
+                local.push_back(roundIds[i]);
+                local.insert(local.end(), rounds[i].seconds, rounds[i].seconds + NUM_PHASES);
+                local.insert(local.end(), rounds[i].counts, rounds[i].counts + NUM_COUNTERS);
+            }
+            int localSize = local.size();
+            std::vector<int> sizes(nprocs), displs(nprocs, 0);
+            MPI_Gather(&localSize, 1, MPI_INT, sizes.data(), 1, MPI_INT, coordinator, MPI_COMM_WORLD);
+            std::vector<double> all;
+            if (rank == coordinator) {
+                for (int p = 1; p < nprocs; p++) {
+                    displs[p] = displs[p - 1] + sizes[p - 1];
+                }
+                all.resize(displs[nprocs - 1] + sizes[nprocs - 1]);
+            }
+            MPI_Gatherv(local.data(), localSize, MPI_DOUBLE, all.data(), sizes.data(), displs.data(), MPI_DOUBLE, coordinator, MPI_COMM_WORLD);
+            if (rank != coordinator) {
+                return;
+            }
+
+            const int stride = kFields + 1;
+            std::vector<double> phaseTotals(nprocs * NUM_PHASES, 0.0);
+            std::ofstream out(path);
+            bool json = endsWith(path, ".json");
+            if (json) {
+                out << "[\n";
+            } else {
+                out << "rank,round";
+                for (int f = 0; f < NUM_PHASES; f++) out << "," << kPhaseNames[f] << "_s";
+                for (int f = 0; f < NUM_COUNTERS; f++) out << "," << kCounterNames[f];
+                out << "\n";
+            }
+            bool first = true;
+            for (int p = 0; p < nprocs; p++) {
+                for (int i = displs[p]; i < displs[p] + sizes[p]; i += stride) {
+                    const double* row = &all[i];
+                    for (int f = 0; f < NUM_PHASES; f++) phaseTotals[p * NUM_PHASES + f] += row[1 + f];
+                    if (json) {
+                        out << (first ? "" : ",\n") << "  {\"rank\": " << p << ", \"round\": " << static_cast<int>(row[0]);
+                        for (int f = 0; f < NUM_PHASES; f++) out << ", \"" << kPhaseNames[f] << "_s\": " << row[1 + f];
+                        for (int f = 0; f < NUM_COUNTERS; f++) out << ", \"" << kCounterNames[f] << "\": " << static_cast<int64_t>(row[1 + NUM_PHASES + f]);
+                        out << "}";
+                    } else {
+                        out << p << "," << static_cast<int>(row[0]);
+                        for (int f = 0; f < NUM_PHASES; f++) out << "," << row[1 + f];
+                        for (int f = 0; f < NUM_COUNTERS; f++) out << "," << static_cast<int64_t>(row[1 + NUM_PHASES + f]);
+                        out << "\n";
+                    }
+                    first = false;
+                }
+            }
+            if (json) {
+                out << "\n]\n";
+            }
+            out.close();
+
+            for (int f = 0; f < NUM_PHASES; f++) {
+                int slowest = 0;
+                for (int p = 1; p < nprocs; p++) {
+                    if (phaseTotals[p * NUM_PHASES + f] > phaseTotals[slowest * NUM_PHASES + f]) slowest = p;
+                }
+                std::cerr << "Metrics " << kPhaseNames[f] << ": " << phaseTotals[slowest * NUM_PHASES + f]
+                          << " (slowest rank " << slowest << ")" << std::endl;
+            }
+            std::cerr << "Metrics written to " << path << std::endl;
+        }
+};
+
+} // end of namespace distributed_kcore
+
+#ifdef KCORE_METRICS
+#define KCORE_METRICS_ROUND(m, r) (m).beginRound(r)
+#define KCORE_TIMER_START(t) auto t = std::chrono::high_resolution_clock::now()
+#define KCORE_TIMER_STOP(m, phase, t) (m).addTime(phase, t)
+#define KCORE_TIMER_EXCLUDE(m, from, phase) (m).subtractTime(from, phase)
+#define KCORE_COUNT(m, counter, value) (m).addCount(counter, value)
+#else
+#define KCORE_METRICS_ROUND(m, r)
+#define KCORE_TIMER_START(t)
+#define KCORE_TIMER_STOP(m, phase, t)
+#define KCORE_TIMER_EXCLUDE(m, from, phase)
+#define KCORE_COUNT(m, counter, value)
+#endif
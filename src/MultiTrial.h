@@ -0,0 +1,279 @@
+/**
+ * @file MultiTrial.h
+ * @brief T independent noise trials of KCore_compute in one graph traversal
+ *
+ * Every vertex carries one lane per trial: its level, whether it is still
+ * active (not a permanent zero) and its noisy round threshold. Lanes are
+ * padded to a multiple of kLaneBlock so that the per-neighbour compare
+ * against the round number is a fixed-width loop the compiler vectorizes.
+ * The coordinator sends all lanes of the levels in one message per worker and
+ * the workers answer with one byte per lane, so a round costs one exchange
+ * no matter how many trials run.
+*/
+
+#pragma once
+
+#include <mpi.h>
+#include <math.h>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "KCore.h"
+
+namespace distributed_kcore {
+
+static constexpr int kLaneBlock = 16;
+// per-lane state bits sent back by the workers
+static constexpr uint8_t kLaneActive = 1;
+static constexpr uint8_t kLaneUp = 2;
+
+// Parameters of one trial; lanes differ in their privacy split and bias.
+struct TrialLane {
+    int factorId;
+    double factor;
+    int biasFactor;
+};
+
+/**
+ * Lane t takes factor id t % F and bias factor (t / F) % B from the option
+ * lists (the positional values when a list is empty), so T = F * B lanes
+ * cover every combination once.
+*/
+inline std::vector<TrialLane> makeTrialLanes(const RunOptions& opts, int factor_id, int bias_factor) {
+    std::vector<int> factorIds = opts.trialFactorIds.empty() ? std::vector<int>{factor_id} : opts.trialFactorIds;
+    std::vector<int> biasFactors = opts.trialBiasFactors.empty() ? std::vector<int>{bias_factor} : opts.trialBiasFactors;
+    std::vector<TrialLane> lanes(opts.trials);
+    for (int t = 0; t < opts.trials; t++) {
+        lanes[t].factorId = factorIds[t % factorIds.size()];
+        lanes[t].factor = factorFromId(lanes[t].factorId);
+        lanes[t].biasFactor = biasFactors[(t / factorIds.size()) % biasFactors.size()];
+    }
+    return lanes;
+}
+
+inline int laneStride(int trials) {
+    return (trials + kLaneBlock - 1) / kLaneBlock * kLaneBlock;
+}
+
+// counts[j] += (row[j] == r) for one block of lanes
+inline void countLaneBlock(const uint16_t* row, uint16_t r, uint32_t* counts) {
+    for (int j = 0; j < kLaneBlock; j++) {
+        counts[j] += (row[j] == r);
+    }
+}
+
+/**
+ * Worker side of round r for all lanes: state holds kLaneActive per lane of
+ * the slice on entry and gets kLaneUp set or kLaneActive cleared for every
+ * lane that was active at level r.
+*/
+inline void workerTrialRound(Graph* graph, int r, int group_index, int offset, int workLoad, int stride, const std::vector<uint16_t>& levels,
+        std::vector<uint8_t>& state, std::vector<GeometricDistribution>& roundNoise, double phi, [[maybe_unused]] MetricsRecorder& metrics, const NoiseSource& noiseSource) {
+    KCORE_TIMER_START(compute_start);
+    int trials = roundNoise.size();
+    double bound = pow((1 + phi), group_index);
+    std::vector<uint32_t> counts(stride);
+    std::vector<int> active;
+    active.reserve(trials);
+    for (int i = 0; i < workLoad; i++) {
+        const uint16_t* own = &levels[static_cast<size_t>(offset + i) * stride];
+        uint8_t* laneState = &state[static_cast<size_t>(i) * stride];
+        active.clear();
+        for (int t = 0; t < trials; t++) {
+            if (own[t] == r && (laneState[t] & kLaneActive)) {
+                active.push_back(t);
+            }
+        }
+        if (active.empty()) {
+            continue;
+        }
+        std::fill(counts.begin(), counts.end(), 0);
+        auto neighbors = graph->getNeighbors(offset + i);
+        for (int ngh : neighbors) {
+            const uint16_t* row = &levels[static_cast<size_t>(ngh) * stride];
+            for (int b = 0; b < stride; b += kLaneBlock) {
+                countLaneBlock(row + b, r, &counts[b]);
+            }
+        }
+        KCORE_COUNT(metrics, COUNT_EDGES_SCANNED, neighbors.size());
+        KCORE_COUNT(metrics, COUNT_ACTIVE_VERTICES, active.size());
+
+        KCORE_TIMER_START(noise_start);
+        double scale = graph->getNeighborScale(offset + i);
+        for (int t : active) {
+            int count = graph->isSparsified() ? static_cast<int>(std::lround(counts[t] * scale)) : counts[t];
+            int U_hat_i = count + noiseSource.sample(roundNoise[t], NOISE_ROUND + 2 * t, r, offset + i);
+            if (U_hat_i > bound) {
+                laneState[t] |= kLaneUp;
+            } else {
+                laneState[t] &= ~kLaneActive;
+            }
+        }
+        KCORE_TIMER_STOP(metrics, PHASE_NOISE, noise_start);
+    }
+    KCORE_TIMER_STOP(metrics, PHASE_COMPUTE, compute_start);
+    KCORE_TIMER_EXCLUDE(metrics, PHASE_COMPUTE, PHASE_NOISE);
+}
+
+/**
+ * Runs the rounds of KCore_compute for every lane at once. Returns the final
+ * levels on the coordinator (vertex v, lane t at v * stride + t) and an empty
+ * vector on the workers.
+*/
+inline std::vector<uint16_t> KCore_compute_trials(int rank, int nprocs, Graph* graph, double epsilon, double phi, int levels_per_group,
+        const std::vector<TrialLane>& lanes, int bias, int n, const RunOptions& opts) {
+    double rounds_param = ceil(4.0 * pow(log_a_to_base_b(n, 1.0 + phi), 1.5));
+    int number_of_rounds = static_cast<int>(rounds_param);
+    int numworkers = nprocs - 1;
+    int chunk = n / numworkers;
+    int extra = n % numworkers;
+    int trials = lanes.size();
+    int stride = laneStride(trials);
+    int workLoadSize = (rank == COORDINATOR) ? n : ((rank == numworkers) ? chunk + extra : chunk);
+    MPI_Status status;
+
+    std::vector<uint16_t> levels(static_cast<size_t>(n) * stride, 0);
+    std::vector<uint8_t> state(static_cast<size_t>(workLoadSize) * stride, 0);
+    std::vector<int16_t> roundThresholds;
+    if (rank == COORDINATOR) {
+        // thresholds beyond any round (or of a non-positive noisy degree) never fire
+        roundThresholds.assign(static_cast<size_t>(n) * stride, -1);
+        for (int t = 0; t < trials; t++) {
+            GeometricDistribution geomThreshold(epsilon * lanes[t].factor);
+            for (int node = 0; node < n; node++) {
+                int64_t noisedDegree = static_cast<int64_t>(graph->getNodeDegree(node)) + opts.noise.sample(geomThreshold, NOISE_THRESHOLD + 2 * t, 0, node);
+                if (bias == 1) {
+                    noisedDegree -= std::min<int64_t>(noisedDegree - 1, lanes[t].biasFactor);
+                }
+                size_t lane = static_cast<size_t>(node) * stride + t;
+                state[lane] = kLaneActive;
+                if (noisedDegree > 0) {
+                    double threshold = ceil(log2(noisedDegree)) * levels_per_group;
+                    if (threshold < INT16_MAX) {
+                        roundThresholds[lane] = static_cast<int16_t>(threshold);
+                    }
+                }
+            }
+        }
+    }
+    std::vector<GeometricDistribution> roundNoise;
+    for (int t = 0; t < trials; t++) {
+        roundNoise.emplace_back((epsilon * (1.0 - lanes[t].factor)) / (2.0 * rounds_param));
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    MetricsRecorder metrics;
+    std::vector<uint8_t> results(rank == COORDINATOR ? state.size() : 0);
+    for (int r = 0; r < number_of_rounds - 2; r++) {
+        KCORE_METRICS_ROUND(metrics, r);
+        int header[3];
+        if (rank == COORDINATOR) {
+            for (size_t lane = 0; lane < roundThresholds.size(); lane++) {
+                if (roundThresholds[lane] == r) {
+                    state[lane] = 0;
+                }
+            }
+            int group_index = r / levels_per_group;
+
+            KCORE_TIMER_START(send_start);
+            int offset = 0;
+            for (int p = 1; p <= numworkers; p++) {
+                int workLoad = (p == numworkers) ? chunk + extra : chunk;
+                header[0] = offset;
+                header[1] = workLoad;
+                header[2] = group_index;
+                MPI_Send(header, 3, MPI_INT, p, FROM_MASTER, MPI_COMM_WORLD);
+                // n * stride lanes can exceed an int count
+                sendChunked(levels.data(), levels.size(), p, FROM_MASTER, MPI_COMM_WORLD);
+                sendChunked(&state[static_cast<size_t>(offset) * stride], static_cast<size_t>(workLoad) * stride, p, FROM_MASTER, MPI_COMM_WORLD);
+                offset += workLoad;
+            }
+            KCORE_TIMER_STOP(metrics, PHASE_SEND, send_start);
+            KCORE_COUNT(metrics, COUNT_BYTES_SENT, numworkers * (sizeof(header) + levels.size() * sizeof(uint16_t)) + state.size());
+
+            KCORE_TIMER_START(recv_start);
+            offset = 0;
+            for (int p = 1; p <= numworkers; p++) {
+                int workLoad = (p == numworkers) ? chunk + extra : chunk;
+                recvChunked(&results[static_cast<size_t>(offset) * stride], static_cast<size_t>(workLoad) * stride, p, FROM_WORKER + p, MPI_COMM_WORLD);
+                offset += workLoad;
+            }
+            KCORE_TIMER_STOP(metrics, PHASE_RECV, recv_start);
+            KCORE_COUNT(metrics, COUNT_BYTES_RECEIVED, results.size());
+
+            KCORE_TIMER_START(apply_start);
+            for (size_t lane = 0; lane < results.size(); lane++) {
+                state[lane] = results[lane] & kLaneActive;
+                // levels only grow by one per round, so the cap is never reached in practice
+                if ((results[lane] & kLaneUp) && state[lane] && levels[lane] < UINT16_MAX) {
+                    levels[lane]++;
+                }
+            }
+            KCORE_TIMER_STOP(metrics, PHASE_APPLY, apply_start);
+        } else {
+            KCORE_TIMER_START(recv_start);
+            MPI_Recv(header, 3, MPI_INT, COORDINATOR, FROM_MASTER, MPI_COMM_WORLD, &status);
+            recvChunked(levels.data(), levels.size(), COORDINATOR, FROM_MASTER, MPI_COMM_WORLD);
+            recvChunked(state.data(), static_cast<size_t>(header[1]) * stride, COORDINATOR, FROM_MASTER, MPI_COMM_WORLD);
+            KCORE_TIMER_STOP(metrics, PHASE_RECV, recv_start);
+            KCORE_COUNT(metrics, COUNT_BYTES_RECEIVED, sizeof(header) + levels.size() * sizeof(uint16_t) + static_cast<size_t>(header[1]) * stride);
+
+            workerTrialRound(graph, r, header[2], header[0], header[1], stride, levels, state, roundNoise, phi, metrics, opts.noise);
+
+            KCORE_TIMER_START(send_start);
+            sendChunked(state.data(), static_cast<size_t>(header[1]) * stride, COORDINATOR, FROM_WORKER + rank, MPI_COMM_WORLD);
+            KCORE_TIMER_STOP(metrics, PHASE_SEND, send_start);
+            KCORE_COUNT(metrics, COUNT_BYTES_SENT, static_cast<size_t>(header[1]) * stride);
+        }
+
+        KCORE_TIMER_START(barrier_start);
+        MPI_Barrier(MPI_COMM_WORLD);
+        KCORE_TIMER_STOP(metrics, PHASE_BARRIER, barrier_start);
+    }
+    if (!opts.metricsPath.empty()) {
+#ifdef KCORE_METRICS
+        metrics.report(opts.metricsPath, rank, nprocs, COORDINATOR);
+#else
+        if (rank == COORDINATOR) {
+            std::cerr << "--metrics ignored: rebuild with -DKCORE_METRICS=ON" << std::endl;
+        }
+#endif
+    }
+    if (rank != COORDINATOR) {
+        levels.clear();
+    }
+    return levels;
+}
+
+/**
+ * Writes one CSV row per vertex (original ids when perm is given) with the
+ * core estimate of every trial; the header names each lane's parameters.
+*/
+inline bool writeTrialEstimates(const std::string& path, const std::vector<double>& cores, int n, const std::vector<TrialLane>& lanes,
+        const std::vector<int>& perm) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Failed to open file: " << path << std::endl;
+        return false;
+    }
+    int trials = lanes.size();
+    out << "vertex";
+    for (int t = 0; t < trials; t++) {
+        out << ",trial" << t << "_factor" << lanes[t].factorId << "_bias" << lanes[t].biasFactor;
+    }
+    out << "\n";
+    for (int i = 0; i < n; i++) {
+        size_t id = perm.empty() ? i : perm[i];
+        out << i;
+        for (int t = 0; t < trials; t++) {
+            out << "," << cores[id * trials + t];
+        }
+        out << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+} // end of namespace distributed_kcore
@@ -0,0 +1,363 @@
+/**
+ * @file Options.h
+ * @brief Optional command line flags accepted after the positional arguments
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "CounterRng.h"
+#include "HugePages.h"
+#include "Reorder.h"
+#include "Sparsify.h"
+#include "Transport.h"
+
+namespace distributed_kcore {
+
+struct RunOptions {
+    // checkpoint/restart of the round state
+    std::string checkpointDir;
+    int checkpointEvery = 0;
+    bool resume = false;
+
+    // per-round metrics output (.json or .csv), needs a KCORE_METRICS build
+    std::string metricsPath;
+
+    // synthetic input generated in parallel instead of reading <graph> (rmat, er, ba)
+    std::string generate;
+    int edgeFactor = 16;
+    uint64_t graphSeed = 1;
+    std::string generateOut;
+
+    // relabel vertices after loading
+    ReorderKind reorder = REORDER_NONE;
+    // hardware cache/dTLB miss counters around the worker computation
+    bool perfCounters = false;
+
+    // maintain same-level neighbour counts instead of rescanning the adjacency each round
+    bool incremental = false;
+
+    // independent noise trials carried as lanes of one run, see MultiTrial.h
+    int trials = 1;
+    std::vector<int> trialFactorIds;
+    std::vector<int> trialBiasFactors;
+    std::string trialsOut;
+
+    // treat <graph> ("-" for stdin) as a stream of edge updates, see DistributedLDS.h
+    bool stream = false;
+    int batchSize = 10000;
+
+    // ranks on a node share one level array and one CSR (MPI shared-memory windows)
+    bool sharedMemory = false;
+
+    // how the workers return their results each round
+    Transport transport = TRANSPORT_P2P;
+
+    // keep the graph loaded and run jobs from stdin (or a Unix socket), see Service.h
+    bool serve = false;
+    std::string serveSocket;
+
+    // workers sample the round thresholds of their own slice (with initThreads threads each)
+    bool distributedInit = false;
+    int initThreads = 1;
+
+    // page size behind the CSR and level arrays, see HugePages.h
+    PagePolicy hugePages = PAGES_DEFAULT;
+    bool reportHugePages = false;
+
+    // group-varint coded neighbour lists on the workers, see CompressedAdjacency.h
+    bool compress = false;
+
+    // only reader ranks parse <graph> and ship the slices (0: one reader per node), see ParallelLoad.h
+    bool parallelLoad = false;
+    int readers = 0;
+
+    // sampled neighbour lists of high-degree vertices, optionally compared with a run on the full graph
+    SparsifySpec sparsify;
+    bool sparsifyCompare = false;
+
+    // randomness behind the noise (--rng, --seed), see CounterRng.h
+    NoiseSource noise;
+
+    // move slice boundaries between rounds once the slowest worker exceeds the mean by this factor, see Rebalance.h
+    bool rebalance = false;
+    double rebalanceThreshold = 1.25;
+};
+
+// Parses a whole decimal int; false if value is not one.
+inline bool parseInt(const std::string& value, int& result) {
+    try {
+        size_t used = 0;
+        result = std::stoi(value, &used);
+        return used == value.size();
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Parses a whole decimal unsigned 64-bit value (no sign).
+inline bool parseUnsigned(const std::string& value, uint64_t& result) {
+    if (value.empty() || value[0] == '-' || value[0] == '+') {
+        return false;
+    }
+    try {
+        size_t used = 0;
+        result = std::stoull(value, &used);
+        return used == value.size();
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+inline bool parseDouble(const std::string& value, double& result) {
+    try {
+        size_t used = 0;
+        result = std::stod(value, &used);
+        return used == value.size();
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Parses a comma-separated list of ints.
+inline bool parseIntList(const std::string& value, std::vector<int>& result) {
+    result.clear();
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        int parsed;
+        if (!parseInt(item, parsed)) {
+            return false;
+        }
+        result.push_back(parsed);
+    }
+    return !result.empty();
+}
+
+// Flags are of the form --name or --name=value and follow the positional arguments.
+// Returns false (after printing the offending flag) if a flag is not recognised.
+inline bool parseRunOptions(int argc, char** argv, int first, RunOptions& opts) {
+    bool seeded = false;
+    for (int i = first; i < argc; i++) {
+        std::string arg = argv[i];
+        std::string name = arg;
+        std::string value;
+        size_t eq = arg.find('=');
+        if (eq != std::string::npos) {
+            name = arg.substr(0, eq);
+            value = arg.substr(eq + 1);
+        }
+
+        if (name == "--checkpoint-dir") {
+            opts.checkpointDir = value;
+        } else if (name == "--checkpoint-every") {
+            if (!parseInt(value, opts.checkpointEvery)) {
+                std::cerr << "Bad checkpoint interval: " << value << " (expected a non-negative integer, 0 = adaptive)" << std::endl;
+                return false;
+            }
+        } else if (name == "--resume") {
+            opts.resume = true;
+        } else if (name == "--metrics") {
+            opts.metricsPath = value;
+        } else if (name == "--generate") {
+            opts.generate = value;
+        } else if (name == "--edge-factor") {
+            if (!parseInt(value, opts.edgeFactor)) {
+                std::cerr << "Bad edge factor: " << value << " (expected a positive integer)" << std::endl;
+                return false;
+            }
+        } else if (name == "--graph-seed") {
+            if (!parseUnsigned(value, opts.graphSeed)) {
+                std::cerr << "Bad graph seed: " << value << " (expected an unsigned integer)" << std::endl;
+                return false;
+            }
+        } else if (name == "--generate-out") {
+            opts.generateOut = value;
+        } else if (name == "--reorder") {
+            if (!parseReorderKind(value, opts.reorder)) {
+                std::cerr << "Unknown reordering: " << value << " (expected none, degree or rcm)" << std::endl;
+                return false;
+            }
+        } else if (name == "--perf-counters") {
+            opts.perfCounters = true;
+        } else if (name == "--incremental") {
+            opts.incremental = true;
+        } else if (name == "--trials") {
+            if (!parseInt(value, opts.trials)) {
+                std::cerr << "Bad trial count: " << value << " (expected a positive integer)" << std::endl;
+                return false;
+            }
+        } else if (name == "--trial-factors") {
+            if (!parseIntList(value, opts.trialFactorIds)) {
+                std::cerr << "Bad trial factors: " << value << " (expected comma-separated factor ids)" << std::endl;
+                return false;
+            }
+        } else if (name == "--trial-bias-factors") {
+            if (!parseIntList(value, opts.trialBiasFactors)) {
+                std::cerr << "Bad trial bias factors: " << value << " (expected comma-separated integers)" << std::endl;
+                return false;
+            }
+        } else if (name == "--trials-out") {
+            opts.trialsOut = value;
+        } else if (name == "--stream") {
+            opts.stream = true;
+        } else if (name == "--batch-size") {
+            if (!parseInt(value, opts.batchSize)) {
+                std::cerr << "Bad batch size: " << value << " (expected a positive integer)" << std::endl;
+                return false;
+            }
+        } else if (name == "--shared-memory") {
+            opts.sharedMemory = true;
+        } else if (name == "--serve") {
+            opts.serve = true;
+            opts.serveSocket = value;
+        } else if (name == "--distributed-init") {
+            opts.distributedInit = true;
+        } else if (name == "--init-threads") {
+            if (!parseInt(value, opts.initThreads)) {
+                std::cerr << "Bad init thread count: " << value << " (expected a positive integer)" << std::endl;
+                return false;
+            }
+        } else if (name == "--huge-pages") {
+            if (!parsePagePolicy(value, opts.hugePages)) {
+                std::cerr << "Unknown huge page policy: " << value << " (expected off, thp or explicit)" << std::endl;
+                return false;
+            }
+            opts.reportHugePages = true;
+        } else if (name == "--compress") {
+            opts.compress = true;
+        } else if (name == "--readers") {
+            opts.parallelLoad = true;
+            if (!value.empty() && !parseInt(value, opts.readers)) {
+                std::cerr << "Bad reader count: " << value << " (expected a non-negative integer, 0 = auto)" << std::endl;
+                return false;
+            }
+        } else if (name == "--sparsify") {
+            if (!parseSparsify(value, opts.sparsify)) {
+                std::cerr << "Bad sparsification: " << value << " (expected sample:P[:D] with 0 < P <= 1, or cap:D)" << std::endl;
+                return false;
+            }
+        } else if (name == "--sparsify-compare") {
+            opts.sparsifyCompare = true;
+        } else if (name == "--rng") {
+            if (!parseRngBackend(value, opts.noise.backend)) {
+                std::cerr << "Unknown random number generator: " << value << " (expected secure or philox)" << std::endl;
+                return false;
+            }
+        } else if (name == "--seed") {
+            if (!parseUnsigned(value, opts.noise.seed)) {
+                std::cerr << "Bad seed: " << value << " (expected an unsigned integer)" << std::endl;
+                return false;
+            }
+            seeded = true;
+        } else if (name == "--rebalance") {
+            opts.rebalance = true;
+            if (!value.empty()) {
+                if (!parseDouble(value, opts.rebalanceThreshold)) {
+                    std::cerr << "Bad rebalance threshold: " << value << " (expected a number of at least 1)" << std::endl;
+                    return false;
+                }
+            }
+        } else if (name == "--transport") {
+            if (!parseTransport(value, opts.transport)) {
+                std::cerr << "Unknown transport: " << value << " (expected p2p or rma)" << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+    if ((opts.checkpointEvery > 0 || opts.resume) && opts.checkpointDir.empty()) {
+        std::cerr << "--checkpoint-every and --resume require --checkpoint-dir" << std::endl;
+        return false;
+    }
+    if (opts.trials < 1) {
+        std::cerr << "--trials must be at least 1" << std::endl;
+        return false;
+    }
+    if (opts.trials > 1 && (!opts.checkpointDir.empty() || opts.incremental || opts.perfCounters)) {
+        std::cerr << "--trials cannot be combined with --checkpoint-dir, --incremental or --perf-counters" << std::endl;
+        return false;
+    }
+    if (opts.stream && (opts.trials > 1 || !opts.generate.empty() || opts.reorder != REORDER_NONE || !opts.checkpointDir.empty())) {
+        std::cerr << "--stream cannot be combined with --trials, --generate, --reorder or --checkpoint-dir" << std::endl;
+        return false;
+    }
+    if ((opts.sharedMemory || opts.transport != TRANSPORT_P2P) && (opts.trials > 1 || opts.stream)) {
+        std::cerr << "--shared-memory and --transport cannot be combined with --trials or --stream" << std::endl;
+        return false;
+    }
+    if (opts.sharedMemory && opts.reorder != REORDER_NONE) {
+        // relabelGraph rebuilds a private CSR on every rank
+        std::cerr << "--shared-memory cannot be combined with --reorder" << std::endl;
+        return false;
+    }
+    if (opts.serve && (opts.trials > 1 || opts.stream || !opts.checkpointDir.empty())) {
+        std::cerr << "--serve cannot be combined with --trials, --stream or --checkpoint-dir" << std::endl;
+        return false;
+    }
+    if (opts.distributedInit && (opts.trials > 1 || opts.stream || !opts.checkpointDir.empty())) {
+        // checkpoints store the thresholds on the coordinator
+        std::cerr << "--distributed-init cannot be combined with --trials, --stream or --checkpoint-dir" << std::endl;
+        return false;
+    }
+    if (opts.compress && (opts.sharedMemory || opts.stream)) {
+        std::cerr << "--compress cannot be combined with --shared-memory or --stream" << std::endl;
+        return false;
+    }
+    if (opts.parallelLoad && (opts.stream || opts.sharedMemory || !opts.generate.empty())) {
+        std::cerr << "--readers cannot be combined with --stream, --shared-memory or --generate" << std::endl;
+        return false;
+    }
+    if (opts.parallelLoad && opts.readers < 0) {
+        std::cerr << "--readers must be non-negative (0 = auto)" << std::endl;
+        return false;
+    }
+    if (opts.sparsify.kind != SPARSIFY_NONE && (opts.stream || opts.sharedMemory || opts.rebalance)) {
+        // the lists are rebuilt in place and the full degrees stay with the slice
+        std::cerr << "--sparsify cannot be combined with --stream, --shared-memory or --rebalance" << std::endl;
+        return false;
+    }
+    if (opts.sparsifyCompare && (opts.sparsify.kind == SPARSIFY_NONE || opts.trials > 1 || opts.serve || opts.compress || !opts.checkpointDir.empty())) {
+        std::cerr << "--sparsify-compare requires --sparsify and cannot be combined with --trials, --serve, --compress or --checkpoint-dir" << std::endl;
+        return false;
+    }
+    if (seeded && opts.noise.backend == RNG_SECURE) {
+        std::cerr << "--seed requires --rng=philox" << std::endl;
+        return false;
+    }
+    if (opts.rebalance && (opts.trials > 1 || opts.stream || opts.sharedMemory || opts.compress)) {
+        // slices are moved as plain CSR owned by each rank
+        std::cerr << "--rebalance cannot be combined with --trials, --stream, --shared-memory or --compress" << std::endl;
+        return false;
+    }
+    if (opts.rebalanceThreshold < 1.0) {
+        std::cerr << "--rebalance threshold must be at least 1" << std::endl;
+        return false;
+    }
+    if (opts.initThreads < 1) {
+        std::cerr << "--init-threads must be at least 1" << std::endl;
+        return false;
+    }
+    if (opts.edgeFactor < 1) {
+        std::cerr << "--edge-factor must be at least 1" << std::endl;
+        return false;
+    }
+    if (opts.batchSize < 1) {
+        std::cerr << "--batch-size must be at least 1" << std::endl;
+        return false;
+    }
+    if (opts.checkpointEvery < 0) {
+        std::cerr << "--checkpoint-every must be non-negative (0 = adaptive)" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // end of namespace distributed_kcore
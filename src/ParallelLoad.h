@@ -0,0 +1,311 @@
+/**
+ * @file ParallelLoad.h
+ * @brief Loading the worker slices with a few reader ranks instead of every rank reading the whole file
+ *
+ * With --readers only the reader ranks open <graph>: by default the first
+ * rank of every node, with --readers=R ranks k * p / R for k < R. Reader k
+ * parses the k-th of R equal pieces of the file (edge ranges of a binary
+ * edge list, byte ranges of a text one cut at line starts) and sends every
+ * edge to the workers owning its endpoints with MPI_Alltoallv, batchEdges
+ * edges per reader at a time. Readers are in rank order and so are their
+ * pieces, so every worker receives its edges in file order and builds the
+ * same CSR slice as Graph(file, offset, workLoad). The coordinator gets the
+ * degrees from the workers (Graph::fromDegrees), or nothing when it does
+ * not need them.
+*/
+
+#pragma once
+
+#include <mpi.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Graph.h"
+#include "IdTypes.h"
+
+namespace distributed_kcore {
+
+// Bytes this process has read through read(2) and friends (rchar of /proc/self/io), 0 if unknown.
+inline unsigned long long processBytesRead() {
+    std::ifstream in("/proc/self/io");
+    std::string key;
+    unsigned long long value;
+    while (in >> key >> value) {
+        if (key == "rchar:") {
+            return value;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Collective. Prints, on the coordinator, the bytes all ranks read while
+ * loading (bytesRead is this rank's processBytesRead() difference) next to
+ * the size of the file.
+*/
+inline void reportLoadBytes(unsigned long long bytesRead, const std::string& filename, int rank, int coordinator) {
+    unsigned long long total = 0;
+    MPI_Reduce(&bytesRead, &total, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, coordinator, MPI_COMM_WORLD);
+    if (rank == coordinator) {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        long long size = file.is_open() ? static_cast<long long>(file.tellg()) : 0;
+        std::cerr << "Load Bytes Read: " << total << " (all ranks; file " << size << " bytes, "
+                  << (size > 0 ? static_cast<double>(total) / size : 0.0) << "x)" << std::endl;
+    }
+}
+
+/**
+ * One reader's piece of an edge-list file. next() appends up to maxEdges
+ * (vertex, ngh) pairs of the piece and returns false once it is exhausted.
+*/
+class EdgeRangeReader {
+    private:
+        std::ifstream file;
+        bool binary = false;
+        // binary: edges [edge, lastEdge); text: lines starting in [position, end)
+        uint64_t edge = 0;
+        uint64_t lastEdge = 0;
+        long long position = 0;
+        long long end = 0;
+        std::vector<char> buffer;
+        size_t bufferStart = 0;
+        size_t bufferEnd = 0;
+        std::vector<uint32_t> block;
+        bool finished = false;
+
+        static constexpr size_t kBufferBytes = size_t(1) << 20;
+
+        // Reads more of the file into the buffer, keeping the unparsed tail and
+        // one spare byte to terminate the last line; false at end of file.
+        bool fill() {
+            size_t tail = bufferEnd - bufferStart;
+            std::memmove(buffer.data(), buffer.data() + bufferStart, tail);
+            bufferStart = 0;
+            bufferEnd = tail;
+            if (bufferEnd + 1 >= buffer.size()) {
+                buffer.resize(2 * buffer.size());
+            }
+            file.read(buffer.data() + bufferEnd, buffer.size() - 1 - bufferEnd);
+            bufferEnd += file.gcount();
+            return file.gcount() > 0;
+        }
+
+    public:
+        EdgeRangeReader(const std::string& filename, int reader, int readers) : file(filename, std::ios::binary) {
+            if (!file.is_open()) {
+                std::cerr << "Failed to open file: " << filename << std::endl;
+                finished = true;
+                return;
+            }
+            char magic[sizeof(Graph::kBinaryMagic)] = {0};
+            file.read(magic, sizeof(magic));
+            if (file.gcount() == sizeof(magic) && std::memcmp(magic, Graph::kBinaryMagic, sizeof(magic)) == 0) {
+                binary = true;
+                uint64_t numEdges = 0;
+                file.read(reinterpret_cast<char*>(&numEdges), sizeof(numEdges));
+                edge = numEdges * reader / readers;
+                lastEdge = numEdges * (reader + 1) / readers;
+                file.seekg(sizeof(magic) + sizeof(numEdges) + edge * 2 * sizeof(uint32_t));
+                return;
+            }
+            file.clear();
+            file.seekg(0, std::ios::end);
+            long long size = file.tellg();
+            position = size * reader / readers;
+            end = size * (reader + 1) / readers;
+            buffer.resize(kBufferBytes);
+            // a line belongs to the piece it starts in: unless the piece starts a line, skip to the next one
+            if (position > 0) {
+                file.seekg(position - 1);
+                char c;
+                while (file.get(c) && c != '\n') {
+                    position++;
+                }
+            } else {
+                file.seekg(0);
+            }
+            finished = position >= end;
+        }
+
+        template <class V>
+        bool next(std::vector<std::pair<V, V>>& edges, size_t maxEdges) {
+            if (finished) {
+                return false;
+            }
+            if (binary) {
+                uint64_t count = std::min<uint64_t>(maxEdges, lastEdge - edge);
+                block.resize(2 * count);
+                file.read(reinterpret_cast<char*>(block.data()), block.size() * sizeof(uint32_t));
+                for (uint64_t e = 0; e < count; e++) {
+                    edges.emplace_back(static_cast<V>(block[2 * e]), static_cast<V>(block[2 * e + 1]));
+                }
+                edge += count;
+                finished = (edge >= lastEdge);
+                return !finished;
+            }
+            size_t added = 0;
+            while (added < maxEdges && position < end) {
+                char* line = buffer.data() + bufferStart;
+                char* newline = static_cast<char*>(std::memchr(line, '\n', bufferEnd - bufferStart));
+                if (newline == nullptr && fill()) {
+                    continue;
+                }
+                // the last line of the file may lack its newline
+                char* lineEnd = (newline != nullptr) ? newline : buffer.data() + bufferEnd;
+                if (lineEnd == line && newline == nullptr) {
+                    break;
+                }
+                *lineEnd = '\0';
+                char* after = nullptr;
+                long long vertex = std::strtoll(line, &after, 10);
+                if (after != line) {
+                    char* second = after;
+                    long long ngh = std::strtoll(second, &after, 10);
+                    if (after != second) {
+                        edges.emplace_back(static_cast<V>(vertex), static_cast<V>(ngh));
+                        added++;
+                    }
+                }
+                size_t length = lineEnd - line + (newline != nullptr ? 1 : 0);
+                position += length;
+                bufferStart += length;
+            }
+            finished = (position >= end) || (bufferStart == bufferEnd && !fill());
+            return !finished;
+        }
+};
+
+/**
+ * Collective. Builds the slices of Graph(file, offset, workLoad) on the
+ * workers (worker w owns [(w - 1) * chunk, ...) as in KCore_compute) from
+ * the readers' pieces of the file. The coordinator gets a degree-only graph
+ * if coordinatorDegrees, otherwise an empty one. readers == 0 picks the
+ * first rank of every node.
+*/
+inline Graph* loadDistributedGraph(const std::string& filename, vertex_t n, int rank, int nprocs, int readers, bool coordinatorDegrees,
+        size_t batchEdges = size_t(1) << 20) {
+    int numworkers = nprocs - 1;
+    vertex_t chunk = n / numworkers;
+    vertex_t extra = n % numworkers;
+    // -1 for ids outside [0, n), which no slice holds
+    auto owner = [&](vertex_t v) {
+        if (v < 0 || v >= n) {
+            return -1;
+        }
+        return (chunk > 0) ? static_cast<int>(std::min<vertex_t>(v / chunk, numworkers - 1)) + 1 : numworkers;
+    };
+
+    int isReader = 0;
+    if (readers == 0) {
+        MPI_Comm nodeComm;
+        MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &nodeComm);
+        int nodeRank;
+        MPI_Comm_rank(nodeComm, &nodeRank);
+        MPI_Comm_free(&nodeComm);
+        isReader = (nodeRank == 0) ? 1 : 0;
+    } else {
+        int count = std::min(readers, nprocs);
+        for (int k = 0; k < count; k++) {
+            isReader |= (rank == static_cast<int>(static_cast<long long>(k) * nprocs / count)) ? 1 : 0;
+        }
+    }
+    // reader index = number of readers of lower rank
+    int readerIndex = 0, readerCount = 0;
+    MPI_Exscan(&isReader, &readerIndex, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(&isReader, &readerCount, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    if (rank == 0) {
+        readerIndex = 0;
+    }
+    EdgeRangeReader* reader = isReader ? new EdgeRangeReader(filename, readerIndex, readerCount) : nullptr;
+
+    Graph* graph = nullptr;
+    if (rank != 0) {
+        vertex_t offset = (rank - 1) * chunk;
+        vertex_t workLoad = (rank == numworkers) ? chunk + extra : chunk;
+        graph = new Graph(offset, workLoad);
+    }
+
+    std::vector<std::pair<vertex_t, vertex_t>> parsed;
+    std::vector<std::vector<vertex_t>> outgoing(nprocs);
+    // a worker's edges per sender, replayed in sender order (= file order) once all have arrived
+    std::vector<std::vector<vertex_t>> received(nprocs);
+    std::vector<vertex_t> sendBuffer, recvBuffer;
+    std::vector<int> sendCounts(nprocs), recvCounts(nprocs), sendDispls(nprocs), recvDispls(nprocs);
+    int more = 1;
+    while (more) {
+        parsed.clear();
+        int local = (reader != nullptr && reader->next(parsed, batchEdges)) ? 1 : 0;
+        for (const auto& edge : parsed) {
+            int ownerU = owner(edge.first), ownerV = owner(edge.second);
+            if (ownerU > 0) {
+                outgoing[ownerU].push_back(edge.first);
+                outgoing[ownerU].push_back(edge.second);
+            }
+            if (ownerV > 0 && ownerV != ownerU) {
+                outgoing[ownerV].push_back(edge.first);
+                outgoing[ownerV].push_back(edge.second);
+            }
+        }
+        sendBuffer.clear();
+        for (int p = 0; p < nprocs; p++) {
+            sendCounts[p] = outgoing[p].size();
+            sendDispls[p] = sendBuffer.size();
+            sendBuffer.insert(sendBuffer.end(), outgoing[p].begin(), outgoing[p].end());
+            outgoing[p].clear();
+        }
+        MPI_Alltoall(sendCounts.data(), 1, MPI_INT, recvCounts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+        int total = 0;
+        for (int p = 0; p < nprocs; p++) {
+            recvDispls[p] = total;
+            total += recvCounts[p];
+        }
+        recvBuffer.resize(total);
+        MPI_Alltoallv(sendBuffer.data(), sendCounts.data(), sendDispls.data(), MpiType<vertex_t>::get(),
+                      recvBuffer.data(), recvCounts.data(), recvDispls.data(), MpiType<vertex_t>::get(), MPI_COMM_WORLD);
+        for (int p = 0; p < nprocs; p++) {
+            received[p].insert(received[p].end(), recvBuffer.begin() + recvDispls[p], recvBuffer.begin() + recvDispls[p] + recvCounts[p]);
+        }
+        MPI_Allreduce(&local, &more, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    }
+    delete reader;
+
+    if (graph != nullptr) {
+        for (int p = 0; p < nprocs; p++) {
+            for (size_t e = 0; e < received[p].size(); e += 2) {
+                graph->addEdge(received[p][e], received[p][e + 1]);
+            }
+            std::vector<vertex_t>().swap(received[p]);
+        }
+        graph->finalize();
+    }
+
+    if (!coordinatorDegrees) {
+        return (rank == 0) ? new Graph(0, 0) : graph;
+    }
+    // the coordinator only needs degrees, which the workers know exactly
+    std::vector<edge_t> localDegrees;
+    if (graph != nullptr) {
+        for (vertex_t v = graph->getSliceOffset(); v < graph->getSliceOffset() + graph->getSliceSize(); v++) {
+            localDegrees.push_back(graph->getNeighborCount(v));
+        }
+    }
+    std::vector<edge_t> degrees(rank == 0 ? n : 0);
+    if (rank == 0) {
+        for (int p = 1; p <= numworkers; p++) {
+            vertex_t offset = (p - 1) * chunk;
+            vertex_t workLoad = (p == numworkers) ? chunk + extra : chunk;
+            recvChunked(degrees.data() + offset, workLoad, p, 0, MPI_COMM_WORLD);
+        }
+        graph = Graph::fromDegrees(degrees);
+    } else {
+        sendChunked(localDegrees.data(), localDegrees.size(), 0, 0, MPI_COMM_WORLD);
+    }
+    return graph;
+}
+
+} // end of namespace distributed_kcore
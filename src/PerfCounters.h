@@ -0,0 +1,106 @@
+/**
+ * @file PerfCounters.h
+ * @brief Hardware cache and dTLB miss counters via perf_event_open (Linux only)
+ *
+ * If the counters cannot be opened (not Linux, perf_event_paranoid, no PMU in a
+ * VM) available() is false and all reads return 0.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace distributed_kcore {
+
+enum PerfEvent {
+    PERF_CACHE_MISSES = 0,
+    PERF_DTLB_MISSES,
+    NUM_PERF_EVENTS
+};
+
+static const char* const kPerfEventNames[NUM_PERF_EVENTS] = {"Cache Misses", "dTLB Misses"};
+
+class PerfCounters {
+    private:
+        int fds[NUM_PERF_EVENTS];
+        uint64_t totals[NUM_PERF_EVENTS] = {0};
+
+#ifdef __linux__
+        static int openCounter(uint32_t type, uint64_t config) {
+            struct perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+#endif
+
+    public:
+        PerfCounters() {
+            for (int e = 0; e < NUM_PERF_EVENTS; e++) {
+                fds[e] = -1;
+            }
+#ifdef __linux__
+            fds[PERF_CACHE_MISSES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+            fds[PERF_DTLB_MISSES] = openCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB
+                | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+#endif
+        }
+
+        ~PerfCounters() {
+#ifdef __linux__
+            for (int e = 0; e < NUM_PERF_EVENTS; e++) {
+                if (fds[e] >= 0) {
+                    close(fds[e]);
+                }
+            }
+#endif
+        }
+
+        bool available(PerfEvent e) const {
+            return fds[e] >= 0;
+        }
+
+        void start() {
+#ifdef __linux__
+            for (int e = 0; e < NUM_PERF_EVENTS; e++) {
+                if (fds[e] >= 0) {
+                    ioctl(fds[e], PERF_EVENT_IOC_RESET, 0);
+                    ioctl(fds[e], PERF_EVENT_IOC_ENABLE, 0);
+                }
+            }
+#endif
+        }
+
+        // Adds the events since start() to the totals.
+        void stop() {
+#ifdef __linux__
+            for (int e = 0; e < NUM_PERF_EVENTS; e++) {
+                if (fds[e] >= 0) {
+                    ioctl(fds[e], PERF_EVENT_IOC_DISABLE, 0);
+                    uint64_t value = 0;
+                    if (read(fds[e], &value, sizeof(value)) == sizeof(value)) {
+                        totals[e] += value;
+                    }
+                }
+            }
+#endif
+        }
+
+        uint64_t total(PerfEvent e) const {
+            return totals[e];
+        }
+};
+
+} // end of namespace distributed_kcore
@@ -0,0 +1,335 @@
+/**
+ * @file Rebalance.h
+ * @brief Moving slice boundaries between neighbouring workers while KCore_compute runs
+ *
+ * After every round each worker reports its compute time, the weight of the
+ * vertices it scanned and a histogram (kBuckets buckets of equal vertex
+ * count over its slice) of the weight of the vertices that moved up and so
+ * can be active in the next round, a vertex weighing kVertexWeight plus its
+ * degree. When the slowest worker took more than `threshold` times the mean
+ * compute time, the coordinator places new boundaries that split the
+ * predicted weight evenly. Each boundary may only move inside the two slices
+ * it separates, so vertices (adjacency, plus their thresholds under
+ * --distributed-init) only travel between neighbouring ranks. A move is only
+ * made if the predicted saving over the next few rounds exceeds its
+ * estimated cost, priced from the seconds per edge of the earlier moves.
+*/
+
+#pragma once
+
+#include <mpi.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "Graph.h"
+#include "IdTypes.h"
+
+namespace distributed_kcore {
+
+template <class V>
+class LoadBalancer {
+    private:
+        static constexpr int kBuckets = 64;
+        // weight of an active vertex besides its degree (the noise sample)
+        static constexpr double kVertexWeight = 8.0;
+        // rounds a move is expected to pay off over
+        static constexpr int kHorizon = 4;
+        // per worker: compute seconds, scanned weight, predicted weight and degree sum per bucket
+        static constexpr int kFields = 2 + 2 * kBuckets;
+
+        MPI_Comm comm;
+        int rank;
+        int numworkers;
+        double threshold;
+        std::vector<V> bounds;
+        std::vector<double> local;
+        std::vector<double> all;
+
+        std::vector<V> next;
+        unsigned long long sentVertices = 0;
+        unsigned long long sentEdges = 0;
+        int migrations = 0;
+        int skipped = 0;
+        unsigned long long verticesMoved = 0;
+        unsigned long long edgesMoved = 0;
+        double migrationTime = 0.0;
+        double imbalanceSum = 0.0;
+        int roundsMeasured = 0;
+
+        // First vertex of bucket b of a slice [lo, lo + size).
+        static V bucketStart(V lo, V size, int b) {
+            return lo + static_cast<V>((static_cast<double>(size) * b + kBuckets - 1) / kBuckets);
+        }
+
+        // Starts the transfer of count elements to dest (MPI_PROC_NULL for none) in kMpiChunk pieces.
+        template <class T>
+        void sendPieces(std::vector<MPI_Request>& requests, const T* data, size_t count, int dest) {
+            isendChunked(requests, data, count, dest, 0, comm);
+        }
+
+        template <class T>
+        void recvPieces(std::vector<MPI_Request>& requests, T* data, size_t count, int source) {
+            irecvChunked(requests, data, count, source, 0, comm);
+        }
+
+        /**
+         * One direction of a migration: this rank sends [sendFrom, sendTo) of its
+         * slice to dest and receives what source sends into degrees / lists /
+         * movedThresholds (either neighbour may be MPI_PROC_NULL).
+        */
+        template <class E>
+        void shift(const GraphT<V, E>* graph, const std::vector<int>* thresholds, int dest, V sendFrom, V sendTo, int source,
+                std::vector<E>& degrees, std::vector<V>& lists, std::vector<int>& movedThresholds) {
+            std::vector<E> outDegrees;
+            std::vector<V> outLists;
+            std::vector<int> outThresholds;
+            if (dest != MPI_PROC_NULL) {
+                graph->appendLists(sendFrom, sendTo, outDegrees, outLists);
+                if (thresholds != nullptr) {
+                    V first = graph->getSliceOffset();
+                    outThresholds.assign(thresholds->begin() + (sendFrom - first), thresholds->begin() + (sendTo - first));
+                }
+            }
+            unsigned long long counts[3] = {outDegrees.size(), outLists.size(), outThresholds.size()}, inCounts[3] = {0, 0, 0};
+            MPI_Sendrecv(counts, 3, MPI_UNSIGNED_LONG_LONG, dest, 0, inCounts, 3, MPI_UNSIGNED_LONG_LONG, source, 0, comm, MPI_STATUS_IGNORE);
+            degrees.resize(inCounts[0]);
+            lists.resize(inCounts[1]);
+            movedThresholds.resize(inCounts[2]);
+            std::vector<MPI_Request> requests;
+            recvPieces(requests, degrees.data(), degrees.size(), source);
+            recvPieces(requests, lists.data(), lists.size(), source);
+            recvPieces(requests, movedThresholds.data(), movedThresholds.size(), source);
+            sendPieces(requests, outDegrees.data(), outDegrees.size(), dest);
+            sendPieces(requests, outLists.data(), outLists.size(), dest);
+            sendPieces(requests, outThresholds.data(), outThresholds.size(), dest);
+            MPI_Waitall(static_cast<int>(requests.size()), requests.data(), MPI_STATUSES_IGNORE);
+            sentVertices += outDegrees.size();
+            sentEdges += outLists.size();
+        }
+
+        // Coordinator: new boundaries splitting the predicted weight evenly, each kept between its neighbours' old ones.
+        std::vector<V> proposeBounds(double& totalWeight) const {
+            std::vector<double> cumulative;
+            std::vector<V> starts;
+            totalWeight = 0.0;
+            for (int p = 1; p <= numworkers; p++) {
+                const double* fields = &all[p * kFields];
+                V lo = bounds[p - 1], size = bounds[p] - bounds[p - 1];
+                for (int b = 0; b < kBuckets; b++) {
+                    starts.push_back(bucketStart(lo, size, b));
+                    cumulative.push_back(totalWeight);
+                    totalWeight += fields[2 + b];
+                }
+            }
+            starts.push_back(bounds[numworkers]);
+            cumulative.push_back(totalWeight);
+            std::vector<V> proposed(bounds);
+            size_t k = 0;
+            for (int p = 1; p < numworkers; p++) {
+                double target = totalWeight * p / numworkers;
+                while (k + 1 < cumulative.size() && cumulative[k + 1] <= target) {
+                    k++;
+                }
+                V boundary = starts[k];
+                if (k + 1 < cumulative.size() && cumulative[k + 1] > cumulative[k]) {
+                    double fraction = (target - cumulative[k]) / (cumulative[k + 1] - cumulative[k]);
+                    boundary += static_cast<V>(fraction * (starts[k + 1] - starts[k]));
+                }
+                proposed[p] = std::min(std::max(boundary, bounds[p - 1]), bounds[p + 1]);
+                proposed[p] = std::max(proposed[p], proposed[p - 1]);
+            }
+            return proposed;
+        }
+
+        // Predicted weight of every worker's slice under the given boundaries (linear within a bucket).
+        std::vector<double> predictedWeights(const std::vector<V>& candidate, int field) const {
+            std::vector<double> weights(numworkers + 1, 0.0);
+            for (int p = 1; p <= numworkers; p++) {
+                const double* fields = &all[p * kFields];
+                V lo = bounds[p - 1], size = bounds[p] - bounds[p - 1];
+                for (int b = 0; b < kBuckets; b++) {
+                    V start = bucketStart(lo, size, b), end = bucketStart(lo, size, b + 1);
+                    if (end <= start) {
+                        continue;
+                    }
+                    double weight = fields[field + b];
+                    for (int q = 1; q <= numworkers; q++) {
+                        V overlap = std::min(end, candidate[q]) - std::max(start, candidate[q - 1]);
+                        if (overlap > 0) {
+                            weights[q] += weight * overlap / static_cast<double>(end - start);
+                        }
+                    }
+                }
+            }
+            return weights;
+        }
+
+    public:
+        /**
+         * Collective. Workers pass their current slice, so a graph rebalanced
+         * by an earlier run (--serve) starts from where it was left.
+        */
+        LoadBalancer(int _rank, int nprocs, V sliceOffset, V sliceSize, double _threshold) : rank(_rank), numworkers(nprocs - 1),
+            threshold(_threshold), bounds(nprocs), local(kFields, 0.0) {
+                MPI_Comm_dup(MPI_COMM_WORLD, &comm);
+                std::vector<V> ends(nprocs);
+                V end = (rank == 0) ? 0 : sliceOffset + sliceSize;
+                MPI_Allgather(&end, 1, MpiType<V>::get(), ends.data(), 1, MpiType<V>::get(), comm);
+                bounds[0] = 0;
+                for (int p = 1; p <= numworkers; p++) {
+                    bounds[p] = ends[p];
+                }
+                if (rank == 0) {
+                    all.resize(static_cast<size_t>(nprocs) * kFields);
+                }
+        }
+
+        ~LoadBalancer() {
+            MPI_Comm_free(&comm);
+        }
+
+        const std::vector<V>& getBounds() const {
+            return bounds;
+        }
+
+        /**
+         * Worker side of round r's measurement: its compute time, the vertices
+         * it scanned (those at level r) and the ones that moved up (nextLevels
+         * == 1 with permanentZeros still set), which are the next round's.
+        */
+        template <class E>
+        void measure(const GraphT<V, E>* graph, double seconds, const int* levels, int r, const std::vector<int>& nextLevels,
+                const std::vector<int>& permanentZeros) {
+            std::fill(local.begin(), local.end(), 0.0);
+            local[0] = seconds;
+            V lo = bounds[rank - 1], size = bounds[rank] - bounds[rank - 1];
+            for (V i = 0; i < size; i++) {
+                double degree = graph->getNeighborCount(lo + i);
+                int b = static_cast<int>(static_cast<double>(i) * kBuckets / size);
+                if (levels[lo + i] == r) {
+                    local[1] += kVertexWeight + degree;
+                }
+                if (nextLevels[i] == 1 && permanentZeros[i] != 0) {
+                    local[2 + b] += kVertexWeight + degree;
+                }
+                local[2 + kBuckets + b] += degree;
+            }
+        }
+
+        /**
+         * Collective, after a round. Returns true if the boundaries changed;
+         * the caller then calls migrate() and rebuilds its round buffers.
+        */
+        bool step(int roundsLeft) {
+            MPI_Gather(local.data(), kFields, MPI_DOUBLE, all.data(), kFields, MPI_DOUBLE, 0, comm);
+            int move = 0;
+            std::vector<V> proposed(bounds);
+            if (rank == 0) {
+                double maxTime = 0.0, sumTime = 0.0, sumWeight = 0.0;
+                for (int p = 1; p <= numworkers; p++) {
+                    maxTime = std::max(maxTime, all[p * kFields]);
+                    sumTime += all[p * kFields];
+                    sumWeight += all[p * kFields + 1];
+                }
+                double meanTime = sumTime / numworkers;
+                if (meanTime > 0.0) {
+                    imbalanceSum += maxTime / meanTime;
+                    roundsMeasured++;
+                }
+                double totalWeight = 0.0;
+                if (meanTime > 0.0 && maxTime > threshold * meanTime && roundsLeft > 0) {
+                    proposed = proposeBounds(totalWeight);
+                    std::vector<double> before = predictedWeights(bounds, 2), after = predictedWeights(proposed, 2);
+                    double secondsPerWeight = (sumWeight > 0.0) ? sumTime / sumWeight : 0.0;
+                    double saving = secondsPerWeight * (*std::max_element(before.begin(), before.end()) - *std::max_element(after.begin(), after.end()))
+                                  * std::min(roundsLeft, kHorizon);
+                    // edges that would change owner, priced at what earlier moves cost per edge
+                    std::vector<double> degreesBefore = predictedWeights(bounds, 2 + kBuckets);
+                    double edges = 0.0;
+                    for (int p = 1; p < numworkers; p++) {
+                        V lo = std::min(bounds[p], proposed[p]), hi = std::max(bounds[p], proposed[p]);
+                        int owner = (proposed[p] > bounds[p]) ? p + 1 : p;
+                        V size = bounds[owner] - bounds[owner - 1];
+                        if (size > 0) {
+                            edges += degreesBefore[owner] * (hi - lo) / static_cast<double>(size);
+                        }
+                    }
+                    // the first move is always made, it prices the later ones
+                    double cost = (edgesMoved > 0) ? migrationTime / edgesMoved * edges : 0.0;
+                    move = (proposed != bounds && saving > cost) ? 1 : 0;
+                    skipped += (proposed != bounds && !move) ? 1 : 0;
+                }
+            }
+            MPI_Bcast(&move, 1, MPI_INT, 0, comm);
+            if (move) {
+                MPI_Bcast(proposed.data(), static_cast<int>(proposed.size()), MpiType<V>::get(), 0, comm);
+                next = proposed;
+            }
+            return move != 0;
+        }
+
+        /**
+         * Collective. Moves the workers' slices to the boundaries chosen by
+         * step(): adjacency and, unless thresholds is null (they are kept on
+         * the coordinator), the slice's round thresholds travel to the
+         * neighbouring rank. The coordinator's graph is left alone.
+        */
+        template <class E>
+        void migrate(GraphT<V, E>* graph, std::vector<int>* thresholds) {
+            auto start = std::chrono::high_resolution_clock::now();
+            if (rank != 0) {
+                V oldLo = bounds[rank - 1], oldHi = bounds[rank], newLo = next[rank - 1], newHi = next[rank];
+                int left = (rank > 1) ? rank - 1 : MPI_PROC_NULL;
+                int right = (rank < numworkers) ? rank + 1 : MPI_PROC_NULL;
+                std::vector<E> beforeDegrees, afterDegrees;
+                std::vector<V> beforeLists, afterLists;
+                std::vector<int> beforeThresholds, afterThresholds;
+                // leftwards: the prefix [oldLo, newLo) to the left, the right neighbour's prefix [oldHi, newHi) from it
+                shift(graph, thresholds, newLo > oldLo ? left : MPI_PROC_NULL, oldLo, newLo,
+                      newHi > oldHi ? right : MPI_PROC_NULL, afterDegrees, afterLists, afterThresholds);
+                // rightwards: the suffix [newHi, oldHi) to the right, the left neighbour's suffix [newLo, oldLo) from it
+                shift(graph, thresholds, newHi < oldHi ? right : MPI_PROC_NULL, newHi, oldHi,
+                      newLo < oldLo ? left : MPI_PROC_NULL, beforeDegrees, beforeLists, beforeThresholds);
+                if (thresholds != nullptr) {
+                    std::vector<int> moved(beforeThresholds);
+                    V keepFrom = std::max(newLo, oldLo), keepTo = std::min(newHi, oldHi);
+                    if (keepTo > keepFrom) {
+                        moved.insert(moved.end(), thresholds->begin() + (keepFrom - oldLo), thresholds->begin() + (keepTo - oldLo));
+                    }
+                    moved.insert(moved.end(), afterThresholds.begin(), afterThresholds.end());
+                    thresholds->swap(moved);
+                }
+                graph->reslice(newLo, newHi - newLo, beforeDegrees, beforeLists, afterDegrees, afterLists);
+            }
+            // totals kept on the coordinator, which prices the next move with them
+            unsigned long long moved[2] = {sentVertices, sentEdges}, sum[2] = {0, 0};
+            MPI_Reduce(moved, sum, 2, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, comm);
+            sentVertices = sentEdges = 0;
+            verticesMoved += sum[0];
+            edgesMoved += sum[1];
+            std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+            migrationTime += elapsed.count();
+            migrations++;
+            bounds = next;
+        }
+
+        /**
+         * Prints, on the coordinator, the moves made and skipped,
+         * what they moved and cost (against the total round time) and the
+         * mean ratio of the slowest worker's compute time to the mean.
+        */
+        void report(double totalRoundTime) const {
+            if (rank == 0) {
+                double share = (totalRoundTime > 0.0) ? 100.0 * migrationTime / totalRoundTime : 0.0;
+                std::cerr << "Rebalance: " << migrations << " move(s), " << skipped << " not worth their cost; moved "
+                          << verticesMoved << " vertices / " << edgesMoved << " adjacency entries in " << migrationTime << " s ("
+                          << share << "% of round time)" << std::endl;
+                std::cerr << "Round Imbalance: " << (roundsMeasured > 0 ? imbalanceSum / roundsMeasured : 1.0)
+                          << " (mean slowest/mean worker compute time)" << std::endl;
+            }
+        }
+};
+
+} // end of namespace distributed_kcore
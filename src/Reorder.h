@@ -0,0 +1,210 @@
+/**
+ * @file Reorder.h
+ * @brief Vertex relabeling for locality of the currentLevels[ngh] lookups
+ *
+ * The graph is relabeled once after loading: perm[old] = new. Workers then own
+ * slices of the new ids, and the coordinator maps core numbers back to the
+ * original ids on output.
+*/
+
+#pragma once
+
+#include <mpi.h>
+#include <algorithm>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "Graph.h"
+#include "IdTypes.h"
+
+namespace distributed_kcore {
+
+static constexpr int kReorderTag = 41;
+
+enum ReorderKind {
+    REORDER_NONE,
+    REORDER_DEGREE,  // descending degree: the most looked-up levels share cache lines
+    REORDER_RCM      // reverse Cuthill-McKee: neighbours get nearby ids
+};
+
+inline bool parseReorderKind(const std::string& name, ReorderKind& kind) {
+    if (name == "none") {
+        kind = REORDER_NONE;
+    } else if (name == "degree") {
+        kind = REORDER_DEGREE;
+    } else if (name == "rcm") {
+        kind = REORDER_RCM;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+inline std::vector<int> degreeOrder(const std::vector<int>& degrees) {
+    int n = degrees.size();
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return degrees[a] > degrees[b]; });
+    std::vector<int> perm(n);
+    for (int i = 0; i < n; i++) {
+        perm[order[i]] = i;
+    }
+    return perm;
+}
+
+/**
+ * BFS from the lowest-degree unvisited vertex of every component, visiting
+ * neighbours by increasing degree, then reversed.
+*/
+inline std::vector<int> rcmOrder(const std::vector<int>& degrees, const std::vector<size_t>& offsets, const std::vector<int>& adjacency) {
+    int n = degrees.size();
+    std::vector<int> order;
+    order.reserve(n);
+    std::vector<char> visited(n, 0);
+    std::vector<int> byDegree(n);
+    std::iota(byDegree.begin(), byDegree.end(), 0);
+    std::stable_sort(byDegree.begin(), byDegree.end(), [&](int a, int b) { return degrees[a] < degrees[b]; });
+
+    std::vector<int> frontier;
+    for (int start : byDegree) {
+        if (visited[start]) {
+            continue;
+        }
+        visited[start] = 1;
+        size_t head = order.size();
+        order.push_back(start);
+        while (head < order.size()) {
+            int v = order[head++];
+            frontier.clear();
+            for (size_t e = offsets[v]; e < offsets[v + 1]; e++) {
+                int ngh = adjacency[e];
+                if (!visited[ngh]) {
+                    visited[ngh] = 1;
+                    frontier.push_back(ngh);
+                }
+            }
+            std::stable_sort(frontier.begin(), frontier.end(), [&](int a, int b) { return degrees[a] < degrees[b]; });
+            order.insert(order.end(), frontier.begin(), frontier.end());
+        }
+    }
+
+    std::vector<int> perm(n);
+    for (int i = 0; i < n; i++) {
+        perm[order[i]] = n - 1 - i;
+    }
+    return perm;
+}
+
+/**
+ * Collective. Computes the permutation on the coordinator (RCM gathers the
+ * whole adjacency there), broadcasts it, and rebuilds every rank's graph in
+ * the new ids: workers ship each (v, ngh) of their slice to the worker owning
+ * perm[v]. Returns perm on every rank.
+*/
+inline std::vector<int> relabelGraph(Graph*& graph, ReorderKind kind, int rank, int nprocs, int n) {
+    int numworkers = nprocs - 1;
+    int chunk = n / numworkers;
+    int extra = n % numworkers;
+    // the slices built below: the last worker also takes the extra vertices (all of them when n < numworkers)
+    auto owner = [&](int v) { return (chunk > 0) ? std::min(v / chunk, numworkers - 1) + 1 : numworkers; };
+
+    std::vector<int> perm(n);
+    std::vector<int> degrees;
+    if (rank == 0) {
+        degrees.resize(n);
+        for (int v = 0; v < n; v++) {
+            degrees[v] = graph->getNodeDegree(v);
+        }
+    }
+
+    if (kind == REORDER_RCM) {
+        std::vector<int> sliceDegrees, sliceAdjacency;
+        if (rank != 0) {
+            for (int v = graph->getSliceOffset(); v < graph->getSliceOffset() + graph->getSliceSize(); v++) {
+                NeighborRange neighbors = graph->getNeighbors(v);
+                sliceDegrees.push_back(neighbors.size());
+                sliceAdjacency.insert(sliceAdjacency.end(), neighbors.begin(), neighbors.end());
+            }
+        }
+        // the whole adjacency may exceed an int count, so it is gathered in kMpiChunk pieces
+        std::vector<uint64_t> counts(nprocs);
+        uint64_t count = sliceAdjacency.size();
+        MPI_Gather(&count, 1, MPI_UINT64_T, counts.data(), 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+        std::vector<int> adjacency;
+        if (rank == 0) {
+            adjacency.resize(std::accumulate(counts.begin(), counts.end(), uint64_t(0)));
+            size_t displ = 0;
+            for (int p = 1; p < nprocs; p++) {
+                recvChunked(adjacency.data() + displ, counts[p], p, kReorderTag, MPI_COMM_WORLD);
+                displ += counts[p];
+            }
+        } else {
+            sendChunked(sliceAdjacency.data(), sliceAdjacency.size(), 0, kReorderTag, MPI_COMM_WORLD);
+        }
+        if (rank == 0) {
+            // slices are gathered in worker order, i.e. in vertex order
+            std::vector<size_t> offsets(n + 1, 0);
+            for (int v = 0; v < n; v++) {
+                offsets[v + 1] = offsets[v] + degrees[v];
+            }
+            perm = rcmOrder(degrees, offsets, adjacency);
+        }
+    } else if (rank == 0) {
+        perm = degreeOrder(degrees);
+    }
+    MPI_Bcast(perm.data(), n, MPI_INT, 0, MPI_COMM_WORLD);
+
+    std::vector<std::vector<int>> outgoing(nprocs);
+    if (rank != 0) {
+        for (int v = graph->getSliceOffset(); v < graph->getSliceOffset() + graph->getSliceSize(); v++) {
+            std::vector<int>& out = outgoing[owner(perm[v])];
+            for (int ngh : graph->getNeighbors(v)) {
+                out.push_back(perm[v]);
+                out.push_back(perm[ngh]);
+            }
+        }
+    }
+    // pairwise exchange in kMpiChunk pieces rather than MPI_Alltoallv, whose int counts a large slice overflows
+    std::vector<uint64_t> sendCounts(nprocs), recvCounts(nprocs);
+    for (int p = 0; p < nprocs; p++) {
+        sendCounts[p] = outgoing[p].size();
+    }
+    MPI_Alltoall(sendCounts.data(), 1, MPI_UINT64_T, recvCounts.data(), 1, MPI_UINT64_T, MPI_COMM_WORLD);
+    size_t total = std::accumulate(recvCounts.begin(), recvCounts.end(), uint64_t(0));
+    std::vector<int> recvBuffer(total);
+    std::vector<MPI_Request> requests;
+    size_t displ = 0;
+    for (int p = 0; p < nprocs; p++) {
+        if (recvCounts[p] > 0) {
+            irecvChunked(requests, recvBuffer.data() + displ, recvCounts[p], p, kReorderTag, MPI_COMM_WORLD);
+        }
+        displ += recvCounts[p];
+    }
+    for (int p = 0; p < nprocs; p++) {
+        if (sendCounts[p] > 0) {
+            isendChunked(requests, outgoing[p].data(), outgoing[p].size(), p, kReorderTag, MPI_COMM_WORLD);
+        }
+    }
+    MPI_Waitall(static_cast<int>(requests.size()), requests.data(), MPI_STATUSES_IGNORE);
+    outgoing.clear();
+
+    delete graph;
+    if (rank == 0) {
+        std::vector<int> newDegrees(n);
+        for (int v = 0; v < n; v++) {
+            newDegrees[perm[v]] = degrees[v];
+        }
+        graph = Graph::fromDegrees(newDegrees);
+    } else {
+        int offset = (rank - 1) * chunk;
+        int workLoad = (rank == numworkers) ? chunk + extra : chunk;
+        graph = new Graph(offset, workLoad);
+        for (size_t e = 0; e < total; e += 2) {
+            graph->addDirectedEdge(recvBuffer[e], recvBuffer[e + 1]);
+        }
+        graph->finalize();
+    }
+    return perm;
+}
+
+} // end of namespace distributed_kcore
@@ -0,0 +1,123 @@
+/**
+ * @file RoundEngine.h
+ * @brief Persistent point-to-point requests for the messages of a KCore round
+ *
+ * KCore_compute allocates its round buffers (levels, permanentZeros,
+ * nextLevels, group index) once before the first round, so every message of
+ * a round can be set up once with MPI_Send_init / MPI_Recv_init and restarted
+ * each round with MPI_Startall. Worker slices are fixed for the lifetime of
+ * an engine (a rebalance builds a new one), which drops the per-round
+ * offset/workLoad messages, and the coordinator completes the workers'
+ * results in whatever order they arrive.
+*/
+
+#pragma once
+
+#include <mpi.h>
+#include <algorithm>
+#include <vector>
+#include "IdTypes.h"
+#include "SharedMemory.h"
+
+namespace distributed_kcore {
+
+class RoundEngine {
+    private:
+        // coordinator: levels, group index and permanentZeros to the workers; worker: its results
+        std::vector<MPI_Request> outbound;
+        // coordinator: the workers' results; worker: what the coordinator sends
+        std::vector<MPI_Request> inbound;
+
+        // Arrays longer than kMpiChunk are split the same way on both sides.
+        template <class T>
+        static void sendInit(std::vector<MPI_Request>& requests, const T* data, size_t count, int dest, int tag) {
+            size_t done = 0;
+            do {
+                size_t piece = std::min(kMpiChunk, count - done);
+                requests.emplace_back();
+                MPI_Send_init(data + done, static_cast<int>(piece), MpiType<T>::get(), dest, tag, MPI_COMM_WORLD, &requests.back());
+                done += piece;
+            } while (done < count);
+        }
+
+        template <class T>
+        static void recvInit(std::vector<MPI_Request>& requests, T* data, size_t count, int source, int tag) {
+            size_t done = 0;
+            do {
+                size_t piece = std::min(kMpiChunk, count - done);
+                requests.emplace_back();
+                MPI_Recv_init(data + done, static_cast<int>(piece), MpiType<T>::get(), source, tag, MPI_COMM_WORLD, &requests.back());
+                done += piece;
+            } while (done < count);
+        }
+
+        static void run(std::vector<MPI_Request>& requests) {
+            if (!requests.empty()) {
+                MPI_Startall(static_cast<int>(requests.size()), requests.data());
+                MPI_Waitall(static_cast<int>(requests.size()), requests.data(), MPI_STATUSES_IGNORE);
+            }
+        }
+
+    public:
+        /**
+         * Binds the requests to the round buffers, which must stay where they
+         * are while the engine lives. Worker p owns [bounds[p - 1], bounds[p]),
+         * bounds.back() is n. With returnResults == false (RMA transport) only
+         * the coordinator-to-worker messages are set up.
+        */
+        template <class V>
+        RoundEngine(int rank, int numworkers, int coordinator, int masterTag, int workerTag, const std::vector<V>& bounds, int* levels, int* groupIndex,
+                std::vector<int>& permanentZeros, std::vector<int>& nextLevels, SharedNode* sharedNode, bool returnResults) {
+            V n = bounds[numworkers];
+            auto workLoadOf = [&](int p) { return bounds[p] - bounds[p - 1]; };
+            if (rank == coordinator) {
+                for (int p = 1; p <= numworkers; p++) {
+                    V offset = bounds[p - 1];
+                    sendInit(outbound, groupIndex, 1, p, masterTag);
+                    if (sharedNode == nullptr || sharedNode->receivesLevels(p)) {
+                        sendInit(outbound, levels, n, p, masterTag);
+                    }
+                    sendInit(outbound, &permanentZeros[offset], workLoadOf(p), p, masterTag);
+                    if (returnResults) {
+                        recvInit(inbound, &nextLevels[offset], workLoadOf(p), p, workerTag + p);
+                        recvInit(inbound, &permanentZeros[offset], workLoadOf(p), p, workerTag + p);
+                    }
+                }
+            } else {
+                recvInit(inbound, groupIndex, 1, coordinator, masterTag);
+                if (sharedNode == nullptr || sharedNode->receivesLevels(rank)) {
+                    recvInit(inbound, levels, n, coordinator, masterTag);
+                }
+                recvInit(inbound, permanentZeros.data(), workLoadOf(rank), coordinator, masterTag);
+                if (returnResults) {
+                    sendInit(outbound, nextLevels.data(), workLoadOf(rank), coordinator, workerTag + rank);
+                    sendInit(outbound, permanentZeros.data(), workLoadOf(rank), coordinator, workerTag + rank);
+                }
+            }
+        }
+
+        ~RoundEngine() {
+            for (MPI_Request& request : outbound) {
+                MPI_Request_free(&request);
+            }
+            for (MPI_Request& request : inbound) {
+                MPI_Request_free(&request);
+            }
+        }
+
+        /**
+         * Starts this rank's outbound messages of the round and waits for them.
+         * The coordinator calls it before receive() since its permanentZeros
+         * slices are both sent and received into.
+        */
+        void send() {
+            run(outbound);
+        }
+
+        // Starts this rank's inbound messages of the round and waits for all of them, in any order.
+        void receive() {
+            run(inbound);
+        }
+};
+
+} // end of namespace distributed_kcore
@@ -0,0 +1,106 @@
+/**
+ * @file SameLevelCounts.h
+ * @brief Incrementally maintained U_i (neighbours at the current level) for a worker slice
+ *
+ * Levels start at 0 and grow by at most one per round, so a vertex is at level r
+ * in round r only if it moved in every earlier round. Hence the neighbours at
+ * level r + 1 in round r + 1 are the neighbours at level r in round r minus
+ * those that stayed behind, i.e. the ones whose level is still r in round r + 1.
+ * Each vertex stays behind once, so after the first round every edge is
+ * scanned O(1) times in total instead of once per round.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "Graph.h"
+
+namespace distributed_kcore {
+
+class SameLevelCounts {
+    private:
+        vertex_t offset;
+        vertex_t workLoad;
+        int lastRound = -1;
+        std::vector<int> counts;
+        // every vertex adjacent to the slice ("ghost", sorted) with the slice
+        // vertices it is adjacent to, as local indices
+        std::vector<vertex_t> ghosts;
+        std::vector<size_t> ghostOffsets;
+        std::vector<vertex_t> incidence;
+        uint64_t edgesScanned = 0;
+        uint64_t rescanEdges = 0;
+
+    public:
+        template <class G>
+        SameLevelCounts(const G* graph) : offset(graph->getSliceOffset()), workLoad(graph->getSliceSize()), counts(graph->getSliceSize(), 0) {
+            std::vector<std::pair<vertex_t, vertex_t>> pairs;
+            std::vector<vertex_t> buffer;
+            for (vertex_t i = 0; i < workLoad; i++) {
+                for (vertex_t ngh : graph->getNeighbors(offset + i, buffer)) {
+                    pairs.emplace_back(ngh, i);
+                }
+            }
+            std::sort(pairs.begin(), pairs.end());
+            incidence.reserve(pairs.size());
+            for (size_t e = 0; e < pairs.size(); e++) {
+                if (e == 0 || pairs[e].first != pairs[e - 1].first) {
+                    ghosts.push_back(pairs[e].first);
+                    ghostOffsets.push_back(e);
+                }
+                incidence.push_back(pairs[e].second);
+            }
+            ghostOffsets.push_back(pairs.size());
+        }
+
+        /**
+         * Brings the counts to round r. The first call (or a call that skips a
+         * round) counts from scratch; afterwards only the adjacency of the
+         * vertices left behind at level r - 1 is touched.
+        */
+        template <class Levels>
+        void advance(int r, const Levels& currentLevels) {
+            if (lastRound < 0 || r != lastRound + 1) {
+                std::fill(counts.begin(), counts.end(), 0);
+                for (size_t k = 0; k < ghosts.size(); k++) {
+                    if (currentLevels[ghosts[k]] == r) {
+                        for (size_t e = ghostOffsets[k]; e < ghostOffsets[k + 1]; e++) {
+                            counts[incidence[e]]++;
+                        }
+                    }
+                }
+                edgesScanned += incidence.size();
+            } else {
+                for (size_t k = 0; k < ghosts.size(); k++) {
+                    if (currentLevels[ghosts[k]] == r - 1) {
+                        for (size_t e = ghostOffsets[k]; e < ghostOffsets[k + 1]; e++) {
+                            counts[incidence[e]]--;
+                        }
+                        edgesScanned += ghostOffsets[k + 1] - ghostOffsets[k];
+                    }
+                }
+            }
+            lastRound = r;
+        }
+
+        int get(vertex_t node) const {
+            return counts[node - offset];
+        }
+
+        // What rescanning the adjacency of every active vertex would have cost.
+        void addRescanEdges(size_t edges) {
+            rescanEdges += edges;
+        }
+
+        uint64_t getEdgesScanned() const {
+            return edgesScanned;
+        }
+
+        uint64_t getRescanEdges() const {
+            return rescanEdges;
+        }
+};
+
+} // end of namespace distributed_kcore
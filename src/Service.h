@@ -0,0 +1,287 @@
+/**
+ * @file Service.h
+ * @brief Long-running mode: the graph stays loaded and KCore_compute runs once per job
+ *
+ * Jobs are text lines read by the coordinator from stdin or from clients of a
+ * Unix socket (one client at a time, any number of jobs per connection):
+ *
+ *     <epsilon> <phi> <factor_id> <bias> <bias_factor> [vertex ...]
+ *
+ * An empty vertex list reports every vertex; "quit" stops the service. Each
+ * job is answered on the same channel with a binary record in host byte order:
+ * uint32 status (0 ok, 1 rejected), uint32 count, then count pairs of
+ * (uint32 vertex, float64 core number).
+*/
+
+#pragma once
+
+#include <mpi.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace distributed_kcore {
+
+// Broadcast to the workers as raw bytes.
+struct ServiceJob {
+    double epsilon = 0.0;
+    double phi = 0.0;
+    int factorId = 0;
+    int bias = 0;
+    int biasFactor = 0;
+    int quit = 0;
+};
+
+/**
+ * Parses one job line; returns false (with a reason in error) if it is
+ * malformed or names a vertex outside [0, n).
+*/
+inline bool parseServiceJob(const std::string& line, int n, ServiceJob& job, std::vector<int>& vertices, std::string& error) {
+    std::stringstream ss(line);
+    vertices.clear();
+    if (!(ss >> job.epsilon >> job.phi >> job.factorId >> job.bias >> job.biasFactor)) {
+        error = "expected <epsilon> <phi> <factor_id> <bias> <bias_factor> [vertex ...]";
+        return false;
+    }
+    if (job.epsilon <= 0.0 || job.phi <= 0.0) {
+        error = "epsilon and phi must be positive";
+        return false;
+    }
+    if (job.factorId < 0 || job.factorId > 4) {
+        error = "factor_id must be between 0 and 4";
+        return false;
+    }
+    int v;
+    while (ss >> v) {
+        if (v < 0 || v >= n) {
+            error = "vertex " + std::to_string(v) + " out of range";
+            return false;
+        }
+        vertices.push_back(v);
+    }
+    if (!ss.eof()) {
+        error = "malformed vertex list";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Where the coordinator reads jobs and writes results: stdin/stdout, or the
+ * accepted connection of a Unix socket listening at path.
+*/
+class JobChannel {
+    private:
+        std::string path;
+        int listenFd = -1;
+        int clientFd = -1;
+        std::string pending;
+
+        bool acceptClient() {
+            clientFd = accept(listenFd, nullptr, nullptr);
+            pending.clear();
+            return clientFd >= 0;
+        }
+
+        bool writeAll(const char* data, size_t size) {
+            if (listenFd < 0) {
+                std::cout.write(data, size);
+                return static_cast<bool>(std::cout);
+            }
+            while (size > 0) {
+                // MSG_NOSIGNAL: a client that hung up must not raise SIGPIPE and take the job down
+                ssize_t written = send(clientFd, data, size, MSG_NOSIGNAL);
+                if (written < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (written <= 0) {
+                    return false;
+                }
+                data += written;
+                size -= written;
+            }
+            return true;
+        }
+
+    public:
+        JobChannel(const std::string& _path) : path(_path) {}
+
+        ~JobChannel() {
+            if (clientFd >= 0) {
+                close(clientFd);
+            }
+            if (listenFd >= 0) {
+                close(listenFd);
+                unlink(path.c_str());
+            }
+        }
+
+        bool open() {
+            if (path.empty()) {
+                return true;
+            }
+            sockaddr_un addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            if (path.size() >= sizeof(addr.sun_path)) {
+                std::cerr << "Socket path too long: " << path << std::endl;
+                return false;
+            }
+            std::strcpy(addr.sun_path, path.c_str());
+            listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+            unlink(path.c_str());
+            if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listenFd, 1) != 0) {
+                std::cerr << "Failed to listen on " << path << ": " << std::strerror(errno) << std::endl;
+                return false;
+            }
+            std::cerr << "Listening on " << path << std::endl;
+            return true;
+        }
+
+        // Next job line; when a client disconnects the next one is accepted. False at end of input.
+        bool nextLine(std::string& line) {
+            if (listenFd < 0) {
+                return static_cast<bool>(std::getline(std::cin, line));
+            }
+            while (true) {
+                if (clientFd < 0 && !acceptClient()) {
+                    return false;
+                }
+                size_t newline = pending.find('\n');
+                if (newline != std::string::npos) {
+                    line = pending.substr(0, newline);
+                    pending.erase(0, newline + 1);
+                    return true;
+                }
+                char buffer[4096];
+                ssize_t got = read(clientFd, buffer, sizeof(buffer));
+                if (got <= 0) {
+                    close(clientFd);
+                    clientFd = -1;
+                    continue;
+                }
+                pending.append(buffer, got);
+            }
+        }
+
+        // Closes the current client (if any); the next nextLine() accepts a new one.
+        void dropClient() {
+            if (clientFd >= 0) {
+                close(clientFd);
+                clientFd = -1;
+            }
+            pending.clear();
+        }
+
+        // False if the record could not be written, e.g. because the client disconnected.
+        bool reply(uint32_t status, const std::vector<int>& vertices, const std::vector<double>& cores) {
+            std::string record;
+            uint32_t count = vertices.size();
+            record.append(reinterpret_cast<const char*>(&status), sizeof(status));
+            record.append(reinterpret_cast<const char*>(&count), sizeof(count));
+            for (size_t k = 0; k < vertices.size(); k++) {
+                uint32_t vertex = vertices[k];
+                record.append(reinterpret_cast<const char*>(&vertex), sizeof(vertex));
+                record.append(reinterpret_cast<const char*>(&cores[k]), sizeof(double));
+            }
+            bool ok = writeAll(record.data(), record.size());
+            if (listenFd < 0) {
+                std::cout.flush();
+            }
+            return ok;
+        }
+};
+
+/**
+ * Collective. Serves jobs until the channel ends or a client sends "quit".
+ * run(job) is called on every rank and must return all n core numbers (in
+ * output ids) on the coordinator. Latencies (broadcast, compute and reply)
+ * are reported on stderr next to the graph load time so the warm path can
+ * be compared with a cold CLI run.
+*/
+template <class F>
+void serveJobs(int rank, int coordinator, int n, const std::string& socketPath, double loadTime, F run) {
+    JobChannel* channel = nullptr;
+    int ready = 1;
+    if (rank == coordinator) {
+        channel = new JobChannel(socketPath);
+        ready = channel->open() ? 1 : 0;
+    }
+    MPI_Bcast(&ready, 1, MPI_INT, coordinator, MPI_COMM_WORLD);
+    std::vector<double> latencies;
+    while (ready) {
+        ServiceJob job;
+        std::vector<int> vertices;
+        std::chrono::time_point<std::chrono::high_resolution_clock> job_start;
+        if (rank == coordinator) {
+            std::string line, error;
+            while (true) {
+                if (!channel->nextLine(line) || line == "quit") {
+                    job.quit = 1;
+                    break;
+                }
+                if (line.empty()) {
+                    continue;
+                }
+                job_start = std::chrono::high_resolution_clock::now();
+                if (parseServiceJob(line, n, job, vertices, error)) {
+                    break;
+                }
+                std::cerr << "Rejected job: " << error << std::endl;
+                if (!channel->reply(1, {}, {})) {
+                    std::cerr << "Failed to send reply, dropping client" << std::endl;
+                    channel->dropClient();
+                }
+            }
+        }
+        MPI_Bcast(&job, sizeof(job), MPI_BYTE, coordinator, MPI_COMM_WORLD);
+        if (job.quit) {
+            break;
+        }
+        std::vector<double> cores = run(job);
+        if (rank == coordinator) {
+            if (vertices.empty()) {
+                vertices.resize(n);
+                for (int v = 0; v < n; v++) {
+                    vertices[v] = v;
+                }
+            }
+            std::vector<double> selected(vertices.size());
+            for (size_t k = 0; k < vertices.size(); k++) {
+                selected[k] = cores[vertices[k]];
+            }
+            if (!channel->reply(0, vertices, selected)) {
+                std::cerr << "Failed to send reply, dropping client" << std::endl;
+                channel->dropClient();
+            }
+            std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - job_start;
+            latencies.push_back(elapsed.count());
+            std::cerr << "Job " << latencies.size() << " Time: " << elapsed.count() << std::endl;
+        }
+    }
+    if (rank == coordinator) {
+        std::cerr << "Load Time: " << loadTime << std::endl;
+        if (!latencies.empty()) {
+            std::vector<double> warm(latencies.begin() + (latencies.size() > 1 ? 1 : 0), latencies.end());
+            std::sort(warm.begin(), warm.end());
+            double sum = 0.0;
+            for (double t : warm) {
+                sum += t;
+            }
+            std::cerr << "Jobs: " << latencies.size() << " (first " << latencies[0] << ", warm mean " << sum / warm.size()
+                      << ", warm p50 " << warm[(warm.size() - 1) / 2] << "; a cold run costs load + first)" << std::endl;
+        }
+        delete channel;
+    }
+}
+
+} // end of namespace distributed_kcore
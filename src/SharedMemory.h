@@ -0,0 +1,162 @@
+/**
+ * @file SharedMemory.h
+ * @brief Node-local shared copies of the round levels and the workers' CSR
+ *
+ * Ranks on the same node (MPI_COMM_TYPE_SHARED) share one currentLevels array
+ * and one CSR covering all of the node's worker slices, both allocated with
+ * MPI_Win_allocate_shared by the node leader (the lowest rank on the node).
+ * Each round the coordinator writes the levels straight into its own node's
+ * array and sends them only to the leaders of the other nodes; every rank then
+ * meets its node in sync() before reading them.
+*/
+
+#pragma once
+
+#include <mpi.h>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include "Graph.h"
+
+namespace distributed_kcore {
+
+// Read-only, indexable view of a level array (workerRound accepts it in place of a vector).
+struct LevelView {
+    const int* data;
+
+    int operator[](size_t node) const {
+        return data[node];
+    }
+};
+
+class SharedNode {
+    private:
+        int rank;
+        MPI_Comm nodeComm;
+        int nodeRank;
+        int nodeSize;
+        // world rank of the leader of every rank's node
+        std::vector<int> leaderOf;
+        std::vector<MPI_Win> windows;
+        int* levels = nullptr;
+        size_t sharedBytes = 0;
+
+        /**
+         * Collective over the node. The leader allocates count elements, the
+         * others attach to the leader's segment.
+        */
+        template <class T>
+        T* allocate(size_t count) {
+            MPI_Win win;
+            T* base = nullptr;
+            MPI_Aint size = (nodeRank == 0) ? count * sizeof(T) : 0;
+            MPI_Win_allocate_shared(size, sizeof(T), MPI_INFO_NULL, nodeComm, &base, &win);
+            if (nodeRank != 0) {
+                int dispUnit;
+                MPI_Win_shared_query(win, 0, &size, &dispUnit, &base);
+            }
+            MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+            windows.push_back(win);
+            sharedBytes += count * sizeof(T);
+            return base;
+        }
+
+    public:
+        SharedNode(int _rank, int nprocs, vertex_t n) : rank(_rank), leaderOf(nprocs) {
+            MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &nodeComm);
+            MPI_Comm_rank(nodeComm, &nodeRank);
+            MPI_Comm_size(nodeComm, &nodeSize);
+            int leader = rank;
+            MPI_Bcast(&leader, 1, MPI_INT, 0, nodeComm);
+            MPI_Allgather(&leader, 1, MPI_INT, leaderOf.data(), 1, MPI_INT, MPI_COMM_WORLD);
+            levels = allocate<int>(n);
+        }
+
+        ~SharedNode() {
+            for (MPI_Win& win : windows) {
+                MPI_Win_unlock_all(win);
+                MPI_Win_free(&win);
+            }
+            MPI_Comm_free(&nodeComm);
+        }
+
+        int* getLevels() {
+            return levels;
+        }
+
+        // Whether worker p gets the levels over MPI, i.e. leads a node other than the coordinator's.
+        bool receivesLevels(int p) const {
+            return leaderOf[p] == p && leaderOf[p] != leaderOf[0];
+        }
+
+        // Collective over the node: makes the levels written on the node visible to all of its ranks.
+        void sync() {
+            MPI_Win_sync(windows[0]);
+            MPI_Barrier(nodeComm);
+            MPI_Win_sync(windows[0]);
+        }
+
+        /**
+         * Collective over the node. The leader reads the edge file once for the
+         * range spanned by the node's worker slices (the slices themselves when
+         * ranks are placed on nodes in blocks) into a shared CSR; every worker
+         * gets a Graph::view of its slice. Returns nullptr for an empty slice.
+        */
+        Graph* loadGraph(const std::string& filename, vertex_t offset, vertex_t workLoad) {
+            vertex_t slice[2] = {offset, offset + workLoad};
+            std::vector<vertex_t> slices(2 * nodeSize);
+            MPI_Allgather(slice, 2, MpiType<vertex_t>::get(), slices.data(), 2, MpiType<vertex_t>::get(), nodeComm);
+            vertex_t first = std::numeric_limits<vertex_t>::max(), last = 0;
+            for (int k = 0; k < nodeSize; k++) {
+                if (slices[2 * k + 1] > slices[2 * k]) {
+                    first = std::min(first, slices[2 * k]);
+                    last = std::max(last, slices[2 * k + 1]);
+                }
+            }
+            if (first >= last) {
+                return nullptr;
+            }
+
+            Graph* local = nullptr;
+            edge_t entries = 0;
+            if (nodeRank == 0) {
+                local = new Graph(filename, first, last - first);
+                entries = local->sumAdjList();
+            }
+            MPI_Bcast(&entries, 1, MpiType<edge_t>::get(), 0, nodeComm);
+            edge_t* offsets = allocate<edge_t>(last - first + 1);
+            vertex_t* adjacency = allocate<vertex_t>(entries);
+            if (nodeRank == 0) {
+                offsets[0] = 0;
+                for (vertex_t v = first; v < last; v++) {
+                    NeighborRange neighbors = local->getNeighbors(v);
+                    std::copy(neighbors.begin(), neighbors.end(), adjacency + offsets[v - first]);
+                    offsets[v - first + 1] = offsets[v - first] + neighbors.size();
+                }
+                delete local;
+            }
+            sync();
+            if (workLoad == 0) {
+                return nullptr;
+            }
+            return Graph::view(offset, workLoad, offsets + (offset - first), adjacency);
+        }
+
+        /**
+         * Collective. Prints, on the coordinator, the number of nodes and the
+         * largest node's shared bytes (levels and CSR).
+        */
+        void report(int coordinator) {
+            int isLeader = (nodeRank == 0) ? 1 : 0, nodes = 0;
+            unsigned long long bytes = (nodeRank == 0) ? sharedBytes : 0, maxBytes = 0;
+            MPI_Reduce(&isLeader, &nodes, 1, MPI_INT, MPI_SUM, coordinator, MPI_COMM_WORLD);
+            MPI_Reduce(&bytes, &maxBytes, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX, coordinator, MPI_COMM_WORLD);
+            if (rank == coordinator) {
+                std::cerr << "Shared Memory: " << nodes << " node(s), " << maxBytes << " bytes per node" << std::endl;
+            }
+        }
+};
+
+} // end of namespace distributed_kcore
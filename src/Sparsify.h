@@ -0,0 +1,160 @@
+/**
+ * @file Sparsify.h
+ * @brief Sampling the neighbour lists of high-degree vertices (--sparsify)
+ *
+ * Each worker thins the lists of its slice once after loading:
+ * sample:P[:D] keeps every neighbour of a vertex with more than D (default
+ * kDefaultSparsifyDegree) neighbours with probability P, and cap:D keeps D
+ * neighbours, chosen uniformly, of a vertex with more than D. Either way a
+ * vertex keeps at least one neighbour and the choice depends only on
+ * (--graph-seed, vertex, position), so it does not depend on the number of
+ * ranks. KCore_compute scales the count of same-level neighbours over the
+ * kept list by full / kept degree (Graph::getNeighborScale) before the noise
+ * and the threshold test; thresholds still use the full degree.
+*/
+
+#pragma once
+
+#include <mpi.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "CounterRng.h"
+
+namespace distributed_kcore {
+
+enum SparsifyKind {
+    SPARSIFY_NONE,
+    SPARSIFY_SAMPLE,
+    SPARSIFY_CAP
+};
+
+static constexpr int kDefaultSparsifyDegree = 32;
+// Philox purpose of the sampling streams, apart from the noise purposes of CounterRng.h
+static constexpr uint32_t kSparsifyPurpose = 0x53505253u;
+
+struct SparsifySpec {
+    SparsifyKind kind = SPARSIFY_NONE;
+    // sample: keep probability
+    double rate = 1.0;
+    // lists longer than this are sampled (sample) or cut to this length (cap)
+    long long degree = kDefaultSparsifyDegree;
+};
+
+// Parses sample:P[:D] or cap:D.
+inline bool parseSparsify(const std::string& value, SparsifySpec& spec) {
+    size_t colon = value.find(':');
+    if (colon == std::string::npos) {
+        return false;
+    }
+    std::string kind = value.substr(0, colon);
+    std::string rest = value.substr(colon + 1);
+    try {
+        if (kind == "sample") {
+            size_t second = rest.find(':');
+            spec.kind = SPARSIFY_SAMPLE;
+            spec.rate = std::stod(rest.substr(0, second));
+            if (second != std::string::npos) {
+                spec.degree = std::stoll(rest.substr(second + 1));
+            }
+            return spec.rate > 0.0 && spec.rate <= 1.0 && spec.degree >= 1;
+        }
+        if (kind == "cap") {
+            spec.kind = SPARSIFY_CAP;
+            spec.degree = std::stoll(rest);
+            return spec.degree >= 1;
+        }
+    } catch (const std::exception&) {
+    }
+    return false;
+}
+
+inline double philoxUniform(PhiloxURBG& urbg) {
+    return (urbg() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * Appends to kept the neighbours vertex keeps under spec, in list order.
+ * cap uses selection sampling (Knuth's Algorithm S) so exactly spec.degree
+ * are kept.
+*/
+template <class V, class Range>
+void selectNeighbors(const SparsifySpec& spec, uint64_t seed, V vertex, const Range& neighbors, std::vector<V>& kept) {
+    size_t degree = neighbors.size();
+    if (spec.kind == SPARSIFY_NONE || static_cast<long long>(degree) <= spec.degree) {
+        kept.insert(kept.end(), neighbors.begin(), neighbors.end());
+        return;
+    }
+    PhiloxURBG urbg(seed, kSparsifyPurpose, 0, static_cast<uint64_t>(vertex));
+    if (spec.kind == SPARSIFY_CAP) {
+        size_t needed = spec.degree, remaining = degree;
+        for (V ngh : neighbors) {
+            if (philoxUniform(urbg) * remaining < needed) {
+                kept.push_back(ngh);
+                needed--;
+            }
+            remaining--;
+        }
+        return;
+    }
+    for (V ngh : neighbors) {
+        if (philoxUniform(urbg) < spec.rate) {
+            kept.push_back(ngh);
+        }
+    }
+    if (kept.empty()) {
+        kept.push_back(*(neighbors.begin() + static_cast<size_t>(philoxUniform(urbg) * degree)));
+    }
+}
+
+/**
+ * Collective. Sparsifies every worker's slice and prints, on the coordinator,
+ * the adjacency entries and bytes before and after summed over the workers
+ * and how many vertices were sampled.
+*/
+template <class G>
+void sparsifyWorkerSlices(G* graph, const SparsifySpec& spec, uint64_t seed, int rank, int coordinator) {
+    unsigned long long local[5] = {0, 0, 0, 0, 0}, sum[5] = {0, 0, 0, 0, 0};
+    if (rank != coordinator && graph != nullptr) {
+        local[0] = graph->sumAdjList();
+        local[1] = graph->adjacencyBytes();
+        graph->sparsify([&](auto vertex, const auto& neighbors, auto& kept) {
+            selectNeighbors(spec, seed, vertex, neighbors, kept);
+            local[4] += (kept.size() < neighbors.size()) ? 1 : 0;
+        });
+        local[2] = graph->sumAdjList();
+        local[3] = graph->adjacencyBytes();
+    }
+    MPI_Reduce(local, sum, 5, MPI_UNSIGNED_LONG_LONG, MPI_SUM, coordinator, MPI_COMM_WORLD);
+    if (rank == coordinator) {
+        std::cerr << "Sparsified Adjacency: " << sum[0] << " -> " << sum[2] << " entries, " << sum[1] << " -> " << sum[3]
+                  << " bytes (" << (sum[1] > 0 ? 100.0 * sum[3] / sum[1] : 0.0) << "%), " << sum[4] << " vertices sampled" << std::endl;
+    }
+}
+
+/**
+ * Coordinator. Prints how the cores of the sparsified graph compare with
+ * those of a run on the full graph: the mean and largest ratio
+ * max(a / b, b / a) over the vertices with a positive estimate in both, and
+ * the two algorithm times.
+*/
+inline void reportSparsifiedCores(const std::vector<double>& full, const std::vector<double>& sparse, double fullTime, double sparseTime) {
+    double sum = 0.0, worst = 1.0;
+    size_t counted = 0;
+    for (size_t v = 0; v < full.size() && v < sparse.size(); v++) {
+        if (full[v] > 0.0 && sparse[v] > 0.0) {
+            double ratio = std::max(full[v] / sparse[v], sparse[v] / full[v]);
+            sum += ratio;
+            worst = std::max(worst, ratio);
+            counted++;
+        }
+    }
+    std::cerr << "Sparsified vs Full: approximation factor mean " << (counted > 0 ? sum / counted : 1.0) << ", max " << worst
+              << "; Algorithm Time " << sparseTime << " vs " << fullTime << std::endl;
+}
+
+} // end of namespace distributed_kcore
@@ -0,0 +1,327 @@
+/**
+ * @file SyntheticGraphs.h
+ * @brief Deterministic synthetic graph generators (RMAT/Kronecker, Erdos-Renyi, Barabasi-Albert)
+ *
+ * Edge i depends only on (seed, i), so any range of edge indices can be
+ * generated independently and the full edge list is identical regardless of
+ * how the range is split. generateDistributedGraph() uses this to let every
+ * rank generate 1/p of the edges and route them to the workers owning them.
+*/
+
+#pragma once
+
+#include <mpi.h>
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Graph.h"
+
+namespace distributed_kcore {
+
+inline uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Uniform double in [0, 1) from the top 53 bits.
+inline double splitmixDouble(uint64_t& state) {
+    return (splitmix64(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+enum SyntheticKind {
+    SYNTHETIC_RMAT,
+    SYNTHETIC_ERDOS_RENYI,
+    SYNTHETIC_BARABASI_ALBERT
+};
+
+struct SyntheticGraphSpec {
+    SyntheticKind kind = SYNTHETIC_RMAT;
+    int n = 0;            // number of vertices
+    uint64_t m = 0;       // number of generated edges (n * edges per vertex for Barabasi-Albert)
+    uint64_t seed = 1;
+    // Graph500 RMAT quadrant probabilities, d = 1 - a - b - c
+    double a = 0.57, b = 0.19, c = 0.19;
+
+    static SyntheticGraphSpec rmat(int scale, int edgeFactor, uint64_t seed) {
+        SyntheticGraphSpec spec;
+        spec.kind = SYNTHETIC_RMAT;
+        spec.n = 1 << scale;
+        spec.m = static_cast<uint64_t>(edgeFactor) * spec.n;
+        spec.seed = seed;
+        return spec;
+    }
+
+    static SyntheticGraphSpec erdosRenyi(int n, uint64_t m, uint64_t seed) {
+        SyntheticGraphSpec spec;
+        spec.kind = SYNTHETIC_ERDOS_RENYI;
+        spec.n = n;
+        spec.m = m;
+        spec.seed = seed;
+        return spec;
+    }
+
+    static SyntheticGraphSpec barabasiAlbert(int n, int edgesPerVertex, uint64_t seed) {
+        SyntheticGraphSpec spec;
+        spec.kind = SYNTHETIC_BARABASI_ALBERT;
+        spec.n = n;
+        spec.m = static_cast<uint64_t>(edgesPerVertex) * n;
+        spec.seed = seed;
+        return spec;
+    }
+
+    // kind is one of "rmat", "er", "ba"; m = edgeFactor * n
+    static bool fromName(const std::string& name, int n, int edgeFactor, uint64_t seed, SyntheticGraphSpec& spec) {
+        if (name == "rmat") {
+            spec = SyntheticGraphSpec();
+            spec.kind = SYNTHETIC_RMAT;
+            spec.n = n;
+            spec.m = static_cast<uint64_t>(edgeFactor) * n;
+            spec.seed = seed;
+        } else if (name == "er") {
+            spec = erdosRenyi(n, static_cast<uint64_t>(edgeFactor) * n, seed);
+        } else if (name == "ba") {
+            spec = barabasiAlbert(n, edgeFactor, seed);
+        } else {
+            return false;
+        }
+        return true;
+    }
+};
+
+/**
+ * Bijective scramble of a scale-bit vertex id so that RMAT's high-degree
+ * vertices are not all packed at the low ids (and hence into one worker slice).
+*/
+inline uint32_t scrambleVertex(uint32_t v, int scale, uint64_t seed) {
+    uint64_t mask = (scale >= 32) ? 0xffffffffULL : ((1ULL << scale) - 1);
+    uint64_t x = v;
+    uint64_t key = seed | 1;
+    for (int i = 0; i < 2; i++) {
+        x = (x * (0x9e3779b97f4a7c15ULL | 1) + key) & mask;
+        x ^= x >> ((scale + 1) / 2);
+    }
+    return static_cast<uint32_t>(x);
+}
+
+/**
+ * Barabasi-Albert by the copy model of Batagelj and Brandes: with d edges per
+ * vertex, edge i leaves vertex i / d and its target is a uniformly chosen
+ * endpoint of the 2i endpoints written before it. An even endpoint 2j is the
+ * source of edge j, an odd one 2j + 1 the target of edge j, which is resolved
+ * recursively (Sanders and Schulz), so no shared state is needed.
+*/
+inline int barabasiAlbertTarget(const SyntheticGraphSpec& spec, uint64_t i) {
+    uint64_t d = spec.m / spec.n;
+    while (true) {
+        uint64_t state = spec.seed * 0xd1342543de82ef95ULL + i;
+        // 2i is edge i's own source, which gives a (dropped) self loop
+        uint64_t endpoint = splitmix64(state) % (2 * i + 1);
+        if (endpoint % 2 == 0) {
+            return static_cast<int>((endpoint / 2) / d);
+        }
+        i = endpoint / 2;
+    }
+}
+
+// Generates edge `i`; returns false for self loops, which are dropped.
+inline bool syntheticEdge(const SyntheticGraphSpec& spec, uint64_t i, int& u, int& v) {
+    uint64_t state = spec.seed * 0xd1342543de82ef95ULL + i;
+    if (spec.kind == SYNTHETIC_BARABASI_ALBERT) {
+        u = static_cast<int>(i / (spec.m / spec.n));
+        v = barabasiAlbertTarget(spec, i);
+    } else if (spec.kind == SYNTHETIC_ERDOS_RENYI) {
+        u = static_cast<int>(splitmix64(state) % spec.n);
+        v = static_cast<int>(splitmix64(state) % spec.n);
+    } else {
+        int scale = 0;
+        while ((1 << scale) < spec.n) {
+            scale++;
+        }
+        uint32_t x = 0, y = 0;
+        double ab = spec.a + spec.b;
+        double abc = ab + spec.c;
+        for (int bit = 0; bit < scale; bit++) {
+            double p = splitmixDouble(state);
+            uint32_t right = (p >= spec.a && p < ab) || p >= abc;
+            uint32_t down = p >= ab;
+            x = (x << 1) | down;
+            y = (y << 1) | right;
+        }
+        // n need not be a power of two: fold the 2^scale ids onto [0, n)
+        u = scrambleVertex(x, scale, spec.seed) % spec.n;
+        v = scrambleVertex(y, scale, spec.seed) % spec.n;
+    }
+    return u != v;
+}
+
+// Calls f(u, v) for every non-loop edge with index in [begin, end).
+template <class F>
+void generateEdges(const SyntheticGraphSpec& spec, uint64_t begin, uint64_t end, F f) {
+    int u, v;
+    for (uint64_t i = begin; i < end; i++) {
+        if (syntheticEdge(spec, i, u, v)) {
+            f(u, v);
+        }
+    }
+}
+
+inline std::vector<std::pair<int, int>> generateEdgeList(const SyntheticGraphSpec& spec) {
+    std::vector<std::pair<int, int>> edges;
+    edges.reserve(spec.m);
+    generateEdges(spec, 0, spec.m, [&](int u, int v) { edges.emplace_back(u, v); });
+    return edges;
+}
+
+/**
+ * Collective. Each of the p ranks generates edges [rank * m / p, (rank + 1) * m / p)
+ * and sends every edge to the workers owning its endpoints (worker w owns the
+ * same [offset, offset + workLoad) slice as with file input). Edges are routed
+ * in batches of batchEdges per rank to bound memory. Workers get their CSR
+ * slice; the coordinator gets a degree-only graph assembled from the workers'
+ * degrees. If `out` is given the edges are also written to it in the binary
+ * edge list format with collective MPI-IO, batch by batch and rank by rank.
+ * If `out` cannot be opened every rank returns nullptr and the lowest failing
+ * rank reports why.
+*/
+inline Graph* generateDistributedGraph(const SyntheticGraphSpec& spec, int rank, int nprocs, const std::string& out = "",
+        uint64_t batchEdges = 1 << 24) {
+    int n = spec.n;
+    int numworkers = nprocs - 1;
+    int chunk = n / numworkers;
+    int extra = n % numworkers;
+    auto owner = [&](int v) { return std::min(v / std::max(chunk, 1), numworkers - 1) + 1; };
+
+    Graph* graph = nullptr;
+    if (rank != 0) {
+        int offset = (rank - 1) * chunk;
+        int workLoad = (rank == numworkers) ? chunk + extra : chunk;
+        graph = new Graph(offset, workLoad);
+    }
+
+    uint64_t begin = spec.m * rank / nprocs;
+    uint64_t end = spec.m * (rank + 1) / nprocs;
+    uint64_t localBatches = (end - begin + batchEdges - 1) / batchEdges;
+    uint64_t numBatches = 0;
+    MPI_Allreduce(&localBatches, &numBatches, 1, MPI_UINT64_T, MPI_MAX, MPI_COMM_WORLD);
+
+    MPI_File file;
+    MPI_Offset writePos = 0;
+    if (!out.empty()) {
+        // file handles return errors by default; agree on the outcome so no rank is left in a collective
+        int status = MPI_File_open(MPI_COMM_WORLD, out.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file);
+        int failedRank = (status == MPI_SUCCESS) ? nprocs : rank, firstFailed = nprocs;
+        MPI_Allreduce(&failedRank, &firstFailed, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+        if (firstFailed != nprocs) {
+            if (rank == firstFailed) {
+                char message[MPI_MAX_ERROR_STRING];
+                int length = 0;
+                MPI_Error_string(status, message, &length);
+                std::cerr << "Failed to open " << out << " for writing: " << std::string(message, length) << std::endl;
+            }
+            if (status == MPI_SUCCESS) {
+                MPI_File_close(&file);
+            }
+            delete graph;
+            return nullptr;
+        }
+        MPI_File_set_size(file, 0);
+    }
+
+    std::vector<std::vector<uint32_t>> outgoing(nprocs);
+    std::vector<uint32_t> sendBuffer, recvBuffer, generated;
+    std::vector<int> sendCounts(nprocs), recvCounts(nprocs), sendDispls(nprocs), recvDispls(nprocs);
+    uint64_t written = 0;
+    for (uint64_t batch = 0; batch < numBatches; batch++) {
+        uint64_t batchBegin = std::min(end, begin + batch * batchEdges);
+        uint64_t batchEnd = std::min(end, batchBegin + batchEdges);
+        generated.clear();
+        generateEdges(spec, batchBegin, batchEnd, [&](int u, int v) {
+            int ownerU = owner(u), ownerV = owner(v);
+            outgoing[ownerU].push_back(u);
+            outgoing[ownerU].push_back(v);
+            if (ownerV != ownerU) {
+                outgoing[ownerV].push_back(u);
+                outgoing[ownerV].push_back(v);
+            }
+            if (!out.empty()) {
+                generated.push_back(u);
+                generated.push_back(v);
+            }
+        });
+
+        sendBuffer.clear();
+        for (int p = 0; p < nprocs; p++) {
+            sendCounts[p] = outgoing[p].size();
+            sendDispls[p] = sendBuffer.size();
+            sendBuffer.insert(sendBuffer.end(), outgoing[p].begin(), outgoing[p].end());
+            outgoing[p].clear();
+        }
+        MPI_Alltoall(sendCounts.data(), 1, MPI_INT, recvCounts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+        int total = 0;
+        for (int p = 0; p < nprocs; p++) {
+            recvDispls[p] = total;
+            total += recvCounts[p];
+        }
+        recvBuffer.resize(total);
+        MPI_Alltoallv(sendBuffer.data(), sendCounts.data(), sendDispls.data(), MPI_UINT32_T,
+                      recvBuffer.data(), recvCounts.data(), recvDispls.data(), MPI_UINT32_T, MPI_COMM_WORLD);
+        if (graph != nullptr) {
+            for (int e = 0; e < total; e += 2) {
+                graph->addEdge(recvBuffer[e], recvBuffer[e + 1]);
+            }
+        }
+
+        if (!out.empty()) {
+            // edges are written in rank order within each batch
+            uint64_t count = generated.size() / 2, before = 0, all = 0;
+            MPI_Exscan(&count, &before, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+            MPI_Allreduce(&count, &all, 1, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+            if (rank == 0) {
+                before = 0;
+            }
+            MPI_Offset pos = sizeof(Graph::kBinaryMagic) + sizeof(uint64_t) + (writePos + before) * 2 * sizeof(uint32_t);
+            MPI_File_write_at_all(file, pos, generated.data(), generated.size(), MPI_UINT32_T, MPI_STATUS_IGNORE);
+            writePos += all;
+            written = writePos;
+        }
+    }
+
+    if (!out.empty()) {
+        if (rank == 0) {
+            MPI_File_write_at(file, 0, Graph::kBinaryMagic, sizeof(Graph::kBinaryMagic), MPI_CHAR, MPI_STATUS_IGNORE);
+            MPI_File_write_at(file, sizeof(Graph::kBinaryMagic), &written, 1, MPI_UINT64_T, MPI_STATUS_IGNORE);
+        }
+        MPI_File_close(&file);
+    }
+
+    // the coordinator only needs degrees, which the workers know exactly
+    std::vector<int> localDegrees;
+    if (graph != nullptr) {
+        graph->finalize();
+        for (int v = graph->getSliceOffset(); v < graph->getSliceOffset() + graph->getSliceSize(); v++) {
+            localDegrees.push_back(graph->getNeighborCount(v));
+        }
+    }
+    int localCount = localDegrees.size();
+    std::vector<int> counts(nprocs), displs(nprocs, 0);
+    MPI_Gather(&localCount, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+    std::vector<int> degrees;
+    if (rank == 0) {
+        for (int p = 1; p < nprocs; p++) {
+            displs[p] = displs[p - 1] + counts[p - 1];
+        }
+        degrees.resize(n);
+    }
+    MPI_Gatherv(localDegrees.data(), localCount, MPI_INT, degrees.data(), counts.data(), displs.data(), MPI_INT, 0, MPI_COMM_WORLD);
+    if (rank == 0) {
+        graph = Graph::fromDegrees(degrees);
+    }
+    return graph;
+}
+
+} // end of namespace distributed_kcore
@@ -0,0 +1,94 @@
+/**
+ * @file Transport.h
+ * @brief How the workers return nextLevels and permanentZeros to the coordinator
+ *
+ * TRANSPORT_P2P sends them to persistent receives on the coordinator (see
+ * RoundEngine.h). With TRANSPORT_RMA the coordinator exposes both arrays as
+ * RMA windows and every worker puts its slice at its offset between two
+ * fences. In both cases the coordinator completes the slices in whatever order
+ * the workers finish.
+*/
+
+#pragma once
+
+#include <mpi.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "IdTypes.h"
+
+namespace distributed_kcore {
+
+enum Transport {
+    TRANSPORT_P2P,
+    TRANSPORT_RMA
+};
+
+inline bool parseTransport(const std::string& name, Transport& transport) {
+    if (name == "p2p") {
+        transport = TRANSPORT_P2P;
+    } else if (name == "rma") {
+        transport = TRANSPORT_RMA;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+class RmaResults {
+    private:
+        MPI_Win nextWin;
+        MPI_Win zerosWin;
+
+        // Epoch in which the workers put: nothing precedes the first fence, nothing follows the second.
+        void open() {
+            MPI_Win_fence(MPI_MODE_NOPRECEDE, nextWin);
+            MPI_Win_fence(MPI_MODE_NOPRECEDE, zerosWin);
+        }
+
+        void close() {
+            MPI_Win_fence(MPI_MODE_NOSUCCEED, nextWin);
+            MPI_Win_fence(MPI_MODE_NOSUCCEED, zerosWin);
+        }
+
+    public:
+        /**
+         * Collective. The coordinator's vectors (size n) become the window
+         * memory and must not be reallocated while this object lives; the
+         * workers expose nothing.
+        */
+        RmaResults(int rank, int coordinator, std::vector<int>& nextLevels, std::vector<int>& permanentZeros) {
+            bool exposes = (rank == coordinator);
+            MPI_Win_create(exposes ? nextLevels.data() : nullptr, exposes ? nextLevels.size() * sizeof(int) : 0, sizeof(int),
+                           MPI_INFO_NULL, MPI_COMM_WORLD, &nextWin);
+            MPI_Win_create(exposes ? permanentZeros.data() : nullptr, exposes ? permanentZeros.size() * sizeof(int) : 0, sizeof(int),
+                           MPI_INFO_NULL, MPI_COMM_WORLD, &zerosWin);
+        }
+
+        ~RmaResults() {
+            MPI_Win_free(&nextWin);
+            MPI_Win_free(&zerosWin);
+        }
+
+        // Collective with put(): returns once every worker's slice has landed.
+        void collect() {
+            open();
+            close();
+        }
+
+        // Worker side of collect(): writes [offset, offset + workLoad) of both arrays on the coordinator.
+        // Slices of kMpiChunk elements or more are put in pieces.
+        template <class V>
+        void put(int coordinator, const std::vector<int>& nextLevels, const std::vector<int>& permanentZeros, V offset, V workLoad) {
+            open();
+            for (size_t done = 0; done < static_cast<size_t>(workLoad); done += kMpiChunk) {
+                int piece = static_cast<int>(std::min(kMpiChunk, workLoad - done));
+                MPI_Aint disp = static_cast<MPI_Aint>(offset + done);
+                MPI_Put(nextLevels.data() + done, piece, MPI_INT, coordinator, disp, piece, MPI_INT, nextWin);
+                MPI_Put(permanentZeros.data() + done, piece, MPI_INT, coordinator, disp, piece, MPI_INT, zerosWin);
+            }
+            close();
+        }
+};
+
+} // end of namespace distributed_kcore
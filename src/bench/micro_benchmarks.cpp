@@ -0,0 +1,195 @@
+/**
+ * @file micro_benchmarks.cpp
+ * @brief Google Benchmark microbenchmarks for the KCore hot components
+ *
+ * All inputs are synthetic RMAT graphs (SyntheticGraphs.h), the argument of
+ * each benchmark is the RMAT scale. No MPI calls are made, so the binary is run
+ * directly rather than through mpirun.
+*/
+
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include "../KCore.h"
+#include "../SyntheticGraphs.h"
+
+namespace {
+
+using namespace distributed_kcore;
+
+constexpr int kEdgeFactor = 16;
+constexpr uint64_t kSeed = 42;
+
+struct SyntheticFiles {
+    std::string text;
+    std::string binary;
+    int n;
+};
+
+// Writes the text and binary edge lists for a given scale once per process.
+const SyntheticFiles& syntheticFiles(int scale) {
+    static std::map<int, SyntheticFiles> cache;
+    auto it = cache.find(scale);
+    if (it != cache.end()) {
+        return it->second;
+    }
+    SyntheticGraphSpec spec = SyntheticGraphSpec::rmat(scale, kEdgeFactor, kSeed);
+    std::vector<std::pair<int, int>> edges = generateEdgeList(spec);
+    std::string base = (std::filesystem::temp_directory_path() / ("kcore_bench_rmat" + std::to_string(scale))).string();
+    SyntheticFiles files{base + ".txt", base + ".bin", spec.n};
+    std::ofstream out(files.text);
+    for (const auto& edge : edges) {
+        out << edge.first << " " << edge.second << "\n";
+    }
+    out.close();
+    Graph::writeBinary(files.binary, edges);
+    return cache.emplace(scale, files).first->second;
+}
+
+Graph* syntheticSlice(int scale) {
+    static std::map<int, Graph*> cache;
+    auto it = cache.find(scale);
+    if (it == cache.end()) {
+        const SyntheticFiles& files = syntheticFiles(scale);
+        it = cache.emplace(scale, new Graph(files.binary, 0, files.n)).first;
+    }
+    return it->second;
+}
+
+void BM_GraphLoadText(benchmark::State& state) {
+    const SyntheticFiles& files = syntheticFiles(state.range(0));
+    for (auto _ : state) {
+        Graph graph(files.text, 0, files.n);
+        benchmark::DoNotOptimize(graph.getGraphSize());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(kEdgeFactor) * files.n);
+}
+BENCHMARK(BM_GraphLoadText)->Arg(12)->Arg(16)->Unit(benchmark::kMillisecond);
+
+void BM_GraphLoadBinary(benchmark::State& state) {
+    const SyntheticFiles& files = syntheticFiles(state.range(0));
+    for (auto _ : state) {
+        Graph graph(files.binary, 0, files.n);
+        benchmark::DoNotOptimize(graph.getGraphSize());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(kEdgeFactor) * files.n);
+}
+BENCHMARK(BM_GraphLoadBinary)->Arg(12)->Arg(16)->Unit(benchmark::kMillisecond);
+
+void BM_GetNeighbors(benchmark::State& state) {
+    Graph* graph = syntheticSlice(state.range(0));
+    int n = 1 << state.range(0);
+    int64_t edges = 0;
+    for (auto _ : state) {
+        int64_t sum = 0;
+        for (int i = 0; i < n; i++) {
+            auto neighbors = graph->getNeighbors(i);
+            for (auto ngh : neighbors) {
+                sum += ngh;
+            }
+            edges += neighbors.size();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(edges);
+}
+BENCHMARK(BM_GetNeighbors)->Arg(12)->Arg(16)->Unit(benchmark::kMillisecond);
+
+// Same scan over a compressed slice: group-varint decoding of every list, reports the compression ratio.
+void BM_GetNeighborsCompressed(benchmark::State& state) {
+    const SyntheticFiles& files = syntheticFiles(state.range(0));
+    Graph graph(files.binary, 0, files.n);
+    double csrBytes = graph.adjacencyBytes();
+    graph.compress();
+    int64_t edges = 0;
+    for (auto _ : state) {
+        int64_t sum = 0;
+        for (int i = 0; i < files.n; i++) {
+            auto neighbors = graph.getNeighbors(i);
+            for (auto ngh : neighbors) {
+                sum += ngh;
+            }
+            edges += neighbors.size();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(edges);
+    state.counters["ratio"] = csrBytes / graph.adjacencyBytes();
+}
+BENCHMARK(BM_GetNeighborsCompressed)->Arg(12)->Arg(16)->Unit(benchmark::kMillisecond);
+
+void BM_GeometricSample(benchmark::State& state) {
+    // the per-round lambda for epsilon = 0.5, factor = 1/4 on a ~1M vertex graph
+    GeometricDistribution geom(0.5 * 0.75 / (2.0 * 1000.0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(geom.Sample());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GeometricSample);
+
+void BM_SecureURBG(benchmark::State& state) {
+    SecureURBG& urbg = SecureURBG::GetInstance();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(urbg());
+    }
+    state.SetBytesProcessed(state.iterations() * sizeof(SecureURBG::result_type));
+}
+BENCHMARK(BM_SecureURBG);
+
+void BM_GeometricSamplePhilox(benchmark::State& state) {
+    GeometricDistribution geom(0.5 * 0.75 / (2.0 * 1000.0));
+    NoiseSource noise;
+    noise.backend = RNG_PHILOX;
+    int64_t vertex = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(noise.sample(geom, NOISE_ROUND, 0, vertex++));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GeometricSamplePhilox);
+
+void BM_PhiloxURBG(benchmark::State& state) {
+    PhiloxURBG urbg(1, NOISE_ROUND, 0, 0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(urbg());
+    }
+    state.SetBytesProcessed(state.iterations() * sizeof(PhiloxURBG::result_type));
+}
+BENCHMARK(BM_PhiloxURBG);
+
+void BM_LDSLevelIncrease(benchmark::State& state) {
+    int n = 1 << state.range(0);
+    LDS lds(n, 0.5, 9.0, 40, false);
+    for (auto _ : state) {
+        for (int i = 0; i < n; i++) {
+            lds.level_increase_v2(i, lds.L);
+        }
+        benchmark::DoNotOptimize(lds.L.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_LDSLevelIncrease)->Arg(16)->Arg(20);
+
+void BM_WorkerRound(benchmark::State& state) {
+    Graph* graph = syntheticSlice(state.range(0));
+    int n = 1 << state.range(0);
+    std::vector<int> currentLevels(n, 0);
+    std::vector<int> permanentZeros(n, 1);
+    std::vector<int> nextLevels(n, 0);
+    MetricsRecorder metrics;
+    metrics.beginRound(0);
+    for (auto _ : state) {
+        // round 0: every vertex is active and scans its full adjacency
+        std::fill(permanentZeros.begin(), permanentZeros.end(), 1);
+        workerRound(graph, 0, 0, 0, n, currentLevels, permanentZeros, nextLevels, 0.5 * 0.75 / 2000.0, 0.5, metrics);
+        benchmark::DoNotOptimize(nextLevels.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_WorkerRound)->Arg(12)->Arg(16)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,167 @@
+/**
+ * @file scaling.cpp
+ * @brief MPI strong/weak scaling driver for KCore_compute on synthetic graphs
+ *
+ * Usage: mpirun -np <p> ./kcore_scaling <rmat|er> <scale> <edge_factor> [--weak] [--seed=S] [--header] [--stream[=B]]
+ *        [--transport=p2p|rma] [--huge-pages=off|thp|explicit]
+ *
+ * Prints one table row (ranks, n, m, rounds, load time, algorithm time and mean
+ * round time). Strong scaling keeps the graph fixed; with --weak the number of
+ * vertices grows with the number of workers (RMAT: scale + ceil(log2 workers)).
+ * --transport picks how the workers return their round results (compare the
+ * round_s column of p2p and rma runs); --huge-pages picks the page size of the
+ * CSR and level arrays. With --stream the edges are instead
+ * inserted into a DistributedLDS in batches of B (default 10000) and the row
+ * holds throughput and batch latency.
+ * scaling.sh runs the driver for a list of rank counts.
+*/
+
+#include "../KCore.h"
+#include "../SyntheticGraphs.h"
+#include "../DistributedLDS.h"
+
+int main(int argc, char** argv) {
+    MPI_Init(&argc, &argv);
+    int numProcesses, rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &numProcesses);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (argc < 4 || numProcesses < 2) {
+        if (rank == COORDINATOR) {
+            std::cerr << "Usage: mpirun -np <p >= 2> " << argv[0] << " <rmat|er> <scale> <edge_factor> [--weak] [--seed=S] [--header] [--transport=T] [--huge-pages=M] [--stream[=B]]" << std::endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
+    std::string kind = argv[1];
+    int scale, edgeFactor;
+    if (!distributed_kcore::parseInt(argv[2], scale) || !distributed_kcore::parseInt(argv[3], edgeFactor) || scale < 1 || edgeFactor < 1) {
+        if (rank == COORDINATOR) {
+            std::cerr << "Bad scale or edge factor: " << argv[2] << " " << argv[3] << " (expected positive integers)" << std::endl;
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    bool weak = false, header = false;
+    int streamBatch = 0;
+    distributed_kcore::RunOptions opts;
+    uint64_t seed = 1;
+    for (int i = 4; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--weak") {
+            weak = true;
+        } else if (arg == "--header") {
+            header = true;
+        } else if (arg.rfind("--seed=", 0) == 0) {
+            if (!distributed_kcore::parseUnsigned(arg.substr(7), seed)) {
+                if (rank == COORDINATOR) {
+                    std::cerr << "Bad seed: " << arg.substr(7) << " (expected an unsigned integer)" << std::endl;
+                }
+                MPI_Finalize();
+                return 1;
+            }
+        } else if (arg.rfind("--transport=", 0) == 0) {
+            if (!distributed_kcore::parseTransport(arg.substr(12), opts.transport)) {
+                if (rank == COORDINATOR) {
+                    std::cerr << "Unknown transport: " << arg.substr(12) << std::endl;
+                }
+                MPI_Finalize();
+                return 1;
+            }
+        } else if (arg.rfind("--huge-pages=", 0) == 0) {
+            if (!distributed_kcore::parsePagePolicy(arg.substr(13), distributed_kcore::pagePolicy())) {
+                if (rank == COORDINATOR) {
+                    std::cerr << "Unknown huge page policy: " << arg.substr(13) << std::endl;
+                }
+                MPI_Finalize();
+                return 1;
+            }
+        } else if (arg == "--stream") {
+            streamBatch = 10000;
+        } else if (arg.rfind("--stream=", 0) == 0) {
+            if (!distributed_kcore::parseInt(arg.substr(9), streamBatch) || streamBatch < 1) {
+                if (rank == COORDINATOR) {
+                    std::cerr << "Bad batch size: " << arg.substr(9) << " (expected a positive integer)" << std::endl;
+                }
+                MPI_Finalize();
+                return 1;
+            }
+        } else {
+            if (rank == COORDINATOR) {
+                std::cerr << "Unknown option: " << arg << std::endl;
+            }
+            MPI_Finalize();
+            return 1;
+        }
+    }
+
+    int numworkers = numProcesses - 1;
+    distributed_kcore::SyntheticGraphSpec spec;
+    if (kind == "er") {
+        int n = (1 << scale) * (weak ? numworkers : 1);
+        spec = distributed_kcore::SyntheticGraphSpec::erdosRenyi(n, static_cast<uint64_t>(edgeFactor) * n, seed);
+    } else {
+        int extraScale = 0;
+        while (weak && (1 << extraScale) < numworkers) {
+            extraScale++;
+        }
+        spec = distributed_kcore::SyntheticGraphSpec::rmat(scale + extraScale, edgeFactor, seed);
+    }
+    int n = spec.n;
+
+    if (streamBatch > 0) {
+        std::vector<std::pair<int, int>> edges;
+        if (rank == COORDINATOR) {
+            edges = distributed_kcore::generateEdgeList(spec);
+        }
+        double phi = 0.5;
+        distributed_kcore::DistributedLDS dlds(rank, numProcesses, n, phi, 9.0, static_cast<int>(ceil(distributed_kcore::log_a_to_base_b(n, 1.0 + phi))));
+        size_t next = 0;
+        MPI_Barrier(MPI_COMM_WORLD);
+        distributed_kcore::StreamStats stats = distributed_kcore::runStream(dlds, rank, [&](std::vector<distributed_kcore::EdgeUpdate>& batch) {
+            for (; batch.size() < static_cast<size_t>(streamBatch) && next < edges.size(); next++) {
+                batch.push_back({edges[next].first, edges[next].second, 1});
+            }
+            return !batch.empty();
+        });
+        if (rank == COORDINATOR) {
+            if (header) {
+                std::cout << "ranks\tworkers\tn\tupdates\tbatch\tstream_s\tupdates_per_s\tp50_s\tp99_s\tfixup_rounds" << std::endl;
+            }
+            std::cout << numProcesses << "\t" << numworkers << "\t" << n << "\t" << stats.updates << "\t" << streamBatch << "\t"
+                      << stats.seconds << "\t" << stats.updates / std::max(stats.seconds, 1e-9) << "\t" << stats.p50 << "\t"
+                      << stats.p99 << "\t" << stats.fixupRounds << std::endl;
+        }
+        MPI_Finalize();
+        return 0;
+    }
+
+    double load_start = MPI_Wtime();
+    distributed_kcore::Graph* graph = distributed_kcore::generateDistributedGraph(spec, rank, numProcesses);
+    double load_time = MPI_Wtime() - load_start;
+    double max_load_time = 0.0;
+    MPI_Reduce(&load_time, &max_load_time, 1, MPI_DOUBLE, MPI_MAX, COORDINATOR, MPI_COMM_WORLD);
+
+    double eta = 0.9, epsilon = 0.5, phi = 0.5;
+    double levels_per_group = ceil(distributed_kcore::log_a_to_base_b(n, 1.0 + phi));
+    double lambda = (2.0 / 9.0) * (2.0 * eta - 5.0);
+    int rounds = static_cast<int>(ceil(4.0 * pow(distributed_kcore::log_a_to_base_b(n, 1.0 + phi), 1.5))) - 2;
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double algo_start = MPI_Wtime();
+    distributed_kcore::LDS* lds = distributed_kcore::KCore_compute(rank, numProcesses, graph, eta, epsilon, phi, lambda,
+        static_cast<int>(levels_per_group), 1.0 / 4.0, 0, 0, static_cast<distributed_kcore::vertex_t>(n), opts);
+    double algo_time = MPI_Wtime() - algo_start;
+
+    if (rank == COORDINATOR) {
+        if (header) {
+            std::cout << "ranks\tworkers\tn\tm\trounds\tload_s\talgo_s\tround_s" << std::endl;
+        }
+        std::cout << numProcesses << "\t" << numworkers << "\t" << n << "\t" << spec.m << "\t" << rounds << "\t"
+                  << max_load_time << "\t" << algo_time << "\t" << algo_time / std::max(rounds, 1) << std::endl;
+        delete lds;
+    }
+    delete graph;
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,12 @@
+#!/bin/sh
+# ./bench/scaling.sh <build_dir> <rmat|er> <scale> <edge_factor> [--weak] [--transport=rma] [--huge-pages=thp] [--stream[=B]] "<rank counts>"
+# e.g. ./bench/scaling.sh build rmat 18 16 --weak "2 3 5 9 17"
+build=${1}; kind=${2}; scale=${3}; edge_factor=${4}; shift 4
+mode=""
+while [ "${1#--}" != "${1}" ]; do mode="${mode} ${1}"; shift; done
+header="--header"
+for np in ${1:-"2 3 5 9 17"}
+do
+    mpirun -np ${np} ${build}/kcore_scaling ${kind} ${scale} ${edge_factor} ${mode} ${header}
+    header=""
+done
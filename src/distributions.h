@@ -106,18 +106,25 @@ class SecureURBG {
   absl::Mutex mutex_;
 };
 
-uint64_t Geometric() {
+// The samplers below draw from any 64-bit URBG; the overloads without one use SecureURBG.
+template <class URBG>
+uint64_t Geometric(URBG& urbg) {
   uint64_t result = 1;
   uint64_t r = 0;
   while (r == 0 && result < 1023) {
-    r = SecureURBG::GetInstance()();
+    r = urbg();
     result += absl::countl_zero(r);
   }
   return result;
 }
 
-double UniformDouble() {
-  uint64_t uint_64_number = SecureURBG::GetInstance()();
+uint64_t Geometric() {
+  return Geometric(SecureURBG::GetInstance());
+}
+
+template <class URBG>
+double UniformDouble(URBG& urbg) {
+  uint64_t uint_64_number = urbg();
   // A random integer of Uniform[0, 2^kMantDigits).
   uint64_t i = uint_64_number & kMantissaMask;
 
@@ -130,7 +137,7 @@ double UniformDouble() {
 
   // Extra geometric sampling is needed only when the leading 11 bits are all 0.
   if (j == 0) {
-    exponent += Geometric() - 1;
+    exponent += Geometric(urbg) - 1;
   }
 
   j = (uint64_t{1023} - exponent) << kMantDigits;
@@ -146,6 +153,10 @@ double UniformDouble() {
   return r == 0 ? 1.0 : r;
 }
 
+double UniformDouble() {
+  return UniformDouble(SecureURBG::GetInstance());
+}
+
 
 
 static constexpr double kPi = 3.14159265358979323846;
@@ -174,12 +185,22 @@ class GeometricDistribution {
       return UniformDouble();
     }
 
+    template <class URBG>
+    double GetUniformDouble(URBG& urbg) {
+      return UniformDouble(urbg);
+    }
+
     int64_t Sample() {
+      return Sample(SecureURBG::GetInstance());
+    }
+
+    template <class URBG>
+    int64_t Sample(URBG& urbg) {
       if (lambda_ == std::numeric_limits<double>::infinity()) {
           return 0;
       }
 
-      if (GetUniformDouble() >
+      if (GetUniformDouble(urbg) >
           -1.0 * std::expm1(-1.0 * lambda_ * std::numeric_limits<int64_t>::max())) {
           return std::numeric_limits<int64_t>::max();
       }
@@ -198,7 +219,7 @@ class GeometricDistribution {
           mid = std::min(std::max(mid, lo + 1), hi - 1);
 
           double q = std::expm1(lambda_ * (lo - mid)) / std::expm1(lambda_ * (lo - hi));
-          if (GetUniformDouble() <= q) {
+          if (GetUniformDouble(urbg) <= q) {
             hi = mid;
           } else {
             lo = mid;